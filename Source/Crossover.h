@@ -0,0 +1,232 @@
+/*
+  ==============================================================================
+
+    Crossover.h
+    Created: 19 Oct 2026 1:41:05pm
+    Author:  James Muten
+    Splits the signal into up to four bands with Linkwitz-Riley filters so
+    each band can be given its own wave. The bands are kept in one buffer,
+    band after band and channel after channel, so every band is a contiguous
+    run for the vectorised gain stage and the sum.
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+#include <array>
+
+template <typename Type>
+class Crossover
+{
+public:
+    //==============================================================================================
+    static constexpr int maxBands    = 4;
+    static constexpr int maxChannels = 2;
+
+    // Allocates the band buffer, so not on the audio thread
+    void prepare(const juce::dsp::ProcessSpec& spec)
+    {
+        bands.setSize(maxBands * maxChannels, (int)spec.maximumBlockSize, false, false, true);
+
+        sampleRate   = spec.sampleRate;
+        maxFrequency = (Type)(spec.sampleRate * 0.45); // keeps the crossover points under nyquist at any rate
+
+        updateFrequencies();
+        reset();
+    }
+
+    void reset() noexcept
+    {
+        for (auto& filter : filters)
+            filter.reset();
+    }
+
+    void setNumBands(int newNumBands) noexcept
+    {
+        newNumBands = juce::jlimit(1, maxBands, newNumBands);
+        if (newNumBands != numBands)
+        {
+            numBands = newNumBands;
+            reset();
+        }
+    }
+
+    int getNumBands() const noexcept
+    {
+        return numBands;
+    }
+
+    // The crossover points in Hz, each one is kept above the one below it
+    void setFrequencies(Type low, Type mid, Type high) noexcept
+    {
+        if (low == frequencies[0] && mid == frequencies[1] && high == frequencies[2])
+            return;
+
+        frequencies = { low, mid, high };
+        updateFrequencies();
+    }
+
+    //==============================================================================================
+    /** Splits the block into the bands, afterwards getBand() points at each band's samples.
+        The lower bands go through allpasses at the splits above them, so the bands sum flat. */
+    void split(const juce::dsp::AudioBlock<Type>& input) noexcept
+    {
+        jassert(input.getNumChannels() <= (size_t)maxChannels);
+        jassert(input.getNumSamples() <= (size_t)bands.getNumSamples());
+
+        const auto numChannels = (int)input.getNumChannels();
+        const auto numSamples  = (int)input.getNumSamples();
+
+        auto remainder = getBandBlock(numBands - 1, input);
+        remainder.copyFrom(input);
+
+        for (int split = 0; split + 1 < numBands; split++)
+        {
+            // the split's own input and every band below it, each channel a lane
+            const auto numLanes     = (split + 1) * maxChannels;
+            const auto numRegisters = (numLanes + (int)Lanes::SIMDNumElements - 1) / (int)Lanes::SIMDNumElements;
+
+            Type* laneSamples[maxLanes] = {};
+            for (int channel = 0; channel < numChannels; channel++)
+            {
+                laneSamples[channel] = getBand(numBands - 1, channel);
+                for (int lower = 0; lower < split; lower++)
+                    laneSamples[(lower + 1) * maxChannels + channel] = getBand(lower, channel);
+            }
+
+            auto& filter = filters[(size_t)split];
+            alignas(Lanes::SIMDRegisterSize) Type in[maxRegisters * Lanes::SIMDNumElements] = {};
+            alignas(Lanes::SIMDRegisterSize) Type low[maxRegisters * Lanes::SIMDNumElements];
+            alignas(Lanes::SIMDRegisterSize) Type high[maxRegisters * Lanes::SIMDNumElements];
+
+            for (int i = 0; i < numSamples; i++)
+            {
+                for (int lane = 0; lane < numLanes; lane++)
+                    if (laneSamples[lane] != nullptr)
+                        in[lane] = laneSamples[lane][i];
+
+                for (int r = 0; r < numRegisters; r++)
+                {
+                    const auto offset = (size_t)r * Lanes::SIMDNumElements;
+                    Lanes lowLanes, highLanes;
+                    filter.process(r, Lanes::fromRawArray(in + offset), lowLanes, highLanes);
+                    lowLanes.copyToRawArray(low + offset);
+                    highLanes.copyToRawArray(high + offset);
+                }
+
+                // the split's low half is its band and the high half goes on to the next split,
+                // the lower bands take both halves, which is the allpass at this split
+                for (int channel = 0; channel < numChannels; channel++)
+                {
+                    getBand(split, channel)[i]    = low[channel];
+                    laneSamples[channel][i]       = high[channel];
+
+                    for (int lower = 0; lower < split; lower++)
+                    {
+                        const auto lane = (lower + 1) * maxChannels + channel;
+                        laneSamples[lane][i] = low[lane] + high[lane];
+                    }
+                }
+            }
+        }
+    }
+
+    Type* getBand(int band, int channel) noexcept
+    {
+        return bands.getWritePointer(band * maxChannels + channel);
+    }
+
+    // Adds the bands back together into the output
+    void sum(juce::dsp::AudioBlock<Type>& output) noexcept
+    {
+        output.copyFrom(getBandBlock(0, output));
+
+        for (int band = 1; band < numBands; band++)
+            output.add(getBandBlock(band, output));
+    }
+
+private:
+    using Lanes = juce::dsp::SIMDRegister<Type>;
+
+    // the lanes of the top split, its own input and the two bands below it, for both channels
+    static constexpr int maxLanes     = (maxBands - 1) * maxChannels;
+    static constexpr int maxRegisters = (maxLanes + (int)Lanes::SIMDNumElements - 1) / (int)Lanes::SIMDNumElements;
+
+    /** The filter of juce::dsp::LinkwitzRileyFilter::processSample(channel, x, low, high), run on
+        every lane at once. The low and high outputs come from the same state, and their sum is
+        the allpass the lower bands need, so one filter covers the split and its compensation. */
+    struct LaneFilter
+    {
+        std::array<Lanes, maxRegisters> s1, s2, s3, s4;
+        Type g = 0, h = 0;
+
+        void reset() noexcept
+        {
+            for (auto* state : { &s1, &s2, &s3, &s4 })
+                state->fill(Lanes::expand(Type(0)));
+        }
+
+        void setCutoffFrequency(Type frequency, double rate) noexcept
+        {
+            g = (Type)std::tan(juce::MathConstants<double>::pi * frequency / rate);
+            h = Type(1) / (Type(1) + R2 * g + g * g);
+        }
+
+        void process(int r, Lanes input, Lanes& low, Lanes& high) noexcept
+        {
+            auto& state1 = s1[(size_t)r];
+            auto& state2 = s2[(size_t)r];
+            auto& state3 = s3[(size_t)r];
+            auto& state4 = s4[(size_t)r];
+
+            const auto yH = (input - state1 * (R2 + g) - state2) * h;
+
+            const auto yB = yH * g + state1;
+            state1 = yH * g + yB;
+
+            const auto yL = yB * g + state2;
+            state2 = yB * g + yL;
+
+            const auto yH2 = (yL - state3 * (R2 + g) - state4) * h;
+
+            const auto yB2 = yH2 * g + state3;
+            state3 = yH2 * g + yB2;
+
+            const auto yL2 = yB2 * g + state4;
+            state4 = yB2 * g + yL2;
+
+            low  = yL2;
+            high = yL - yB * R2 + yH - yL2;
+        }
+
+        static constexpr Type R2 = Type(1.41421356237309504880);
+    };
+
+    juce::AudioBuffer<Type> bands;
+    int numBands = 1;
+
+    std::array<Type, maxBands - 1> frequencies{ Type(200), Type(1000), Type(5000) };
+    Type maxFrequency = Type(20000);
+    double sampleRate = 44100.0;
+
+    std::array<LaneFilter, maxBands - 1> filters; // one for each split
+
+    juce::dsp::AudioBlock<Type> getBandBlock(int band, const juce::dsp::AudioBlock<Type>& shape) noexcept
+    {
+        return juce::dsp::AudioBlock<Type>(bands)
+            .getSubsetChannelBlock((size_t)(band * maxChannels), shape.getNumChannels())
+            .getSubBlock(0, shape.getNumSamples());
+    }
+
+    void updateFrequencies() noexcept
+    {
+        Type below = Type(20);
+
+        for (int split = 0; split < maxBands - 1; split++)
+        {
+            below = juce::jlimit(below, maxFrequency, frequencies[split]);
+            filters[(size_t)split].setCutoffFrequency(below, sampleRate);
+        }
+    }
+};
@@ -0,0 +1,121 @@
+/*
+  ==============================================================================
+
+    CustomShape.h
+    Created: 19 Oct 2026 11:14:52am
+    Author:  James Muten
+    A user-drawn wave shape: breakpoints joined by a monotone cubic curve.
+    x runs over one cycle from 0 to 1 with the peak drawn at 0.5, and y is the
+    volume, 1 for untouched and 0 for the full depth.
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+class CustomShape
+{
+public:
+    CustomShape()
+    {
+        setPoints({ { 0.5f, 0.0f } });
+    }
+
+    /** Sets the breakpoints between the fixed end points at (0, 1) and (1, 1) and works out the
+        tangents of the curve through them. Points are clamped to the unit square and sorted by x. */
+    void setPoints(std::vector<juce::Point<float>> newPoints)
+    {
+        for (auto& point : newPoints)
+            point = { juce::jlimit(0.0f, 1.0f, point.x), juce::jlimit(0.0f, 1.0f, point.y) };
+
+        std::sort(newPoints.begin(), newPoints.end(), [](auto a, auto b) { return a.x < b.x; });
+        points = std::move(newPoints);
+
+        xs.assign(1, 0.0f);
+        ys.assign(1, 1.0f);
+        for (auto& point : points)
+        {
+            xs.push_back(point.x);
+            ys.push_back(point.y);
+        }
+        xs.push_back(1.0f);
+        ys.push_back(1.0f);
+
+        updateTangents();
+    }
+
+    const std::vector<juce::Point<float>>& getPoints() const noexcept
+    {
+        return points;
+    }
+
+    // returns the volume at x, always between 0 and 1
+    float evaluate(float x) const noexcept
+    {
+        x = juce::jlimit(0.0f, 1.0f, x);
+
+        auto segment = (size_t)(std::upper_bound(xs.begin(), xs.end(), x) - xs.begin());
+        segment = juce::jlimit((size_t)1, xs.size() - 1, segment) - 1;
+
+        auto width = xs[segment + 1] - xs[segment];
+        if (width <= 0.0f)
+            return ys[segment + 1];
+
+        // cubic Hermite between the two points
+        auto t  = (x - xs[segment]) / width;
+        auto t2 = t * t;
+        auto t3 = t2 * t;
+
+        return (2 * t3 - 3 * t2 + 1) * ys[segment]
+             + (t3 - 2 * t2 + t)     * width * tangents[segment]
+             + (-2 * t3 + 3 * t2)    * ys[segment + 1]
+             + (t3 - t2)             * width * tangents[segment + 1];
+    }
+
+private:
+    std::vector<juce::Point<float>> points;
+    std::vector<float> xs, ys, tangents;
+
+    // Fritsch-Carlson tangents, so the curve never overshoots the points and stays between 0 and 1
+    void updateTangents()
+    {
+        auto numPoints = xs.size();
+        std::vector<float> slopes(numPoints - 1);
+
+        for (size_t i = 0; i + 1 < numPoints; i++)
+        {
+            auto width = xs[i + 1] - xs[i];
+            slopes[i] = width > 0.0f ? (ys[i + 1] - ys[i]) / width : 0.0f;
+        }
+
+        // flat at both ends, so the curve joins itself smoothly when the cycle wraps
+        tangents.assign(numPoints, 0.0f);
+        for (size_t i = 1; i + 1 < numPoints; i++)
+            if (slopes[i - 1] * slopes[i] > 0.0f)
+                tangents[i] = (slopes[i - 1] + slopes[i]) / 2;
+
+        for (size_t i = 0; i + 1 < numPoints; i++)
+        {
+            if (slopes[i] == 0.0f)
+            {
+                tangents[i] = tangents[i + 1] = 0.0f;
+                continue;
+            }
+
+            auto a = tangents[i] / slopes[i];
+            auto b = tangents[i + 1] / slopes[i];
+            auto s = a * a + b * b;
+
+            if (s > 9.0f)
+            {
+                auto tau = 3.0f / std::sqrt(s);
+                tangents[i]     = tau * a * slopes[i];
+                tangents[i + 1] = tau * b * slopes[i];
+            }
+        }
+    }
+};
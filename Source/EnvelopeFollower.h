@@ -0,0 +1,111 @@
+/*
+  ==============================================================================
+
+    EnvelopeFollower.h
+    Created: 19 Oct 2026 5:41:12pm
+    Author:  James Muten
+    Follows the level of the input and turns it into how much of the
+    tremolo to apply, nothing below the threshold and all of it from
+    rangeDecibels above. Everything but the smoothing is vectorised, and
+    the smoothing runs once for all the channels.
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+#include "LevelDetection.h"
+#include <cmath>
+#include <vector>
+
+template <typename Type>
+class EnvelopeFollower
+{
+public:
+    //==============================================================================================
+    static constexpr Type rangeDecibels = Type(24);
+
+    // Allocates for the largest block, call off the audio thread
+    void prepare(const juce::dsp::ProcessSpec& spec)
+    {
+        amounts.resize(spec.maximumBlockSize);
+        scratch.resize(spec.maximumBlockSize);
+        setSampleRate(spec.sampleRate);
+        reset();
+    }
+
+    // Safe on the audio thread, for when the rate changes but the largest block doesn't grow
+    void setSampleRate(double newSampleRate) noexcept
+    {
+        sampleRate = newSampleRate;
+        updateCoefficients();
+    }
+
+    void reset() noexcept
+    {
+        envelope = Type(0);
+    }
+
+    void setTimes(Type attackMilliseconds, Type releaseMilliseconds) noexcept
+    {
+        if (attackMilliseconds == attackTime && releaseMilliseconds == releaseTime)
+            return;
+
+        attackTime  = attackMilliseconds;
+        releaseTime = releaseMilliseconds;
+        updateCoefficients();
+    }
+
+    void setThreshold(Type decibels) noexcept
+    {
+        if (decibels == thresholdDecibels)
+            return;
+
+        thresholdDecibels = decibels;
+        threshold = juce::Decibels::decibelsToGain(decibels);
+        inverseRange = Type(1) / (threshold * (juce::Decibels::decibelsToGain(rangeDecibels) - Type(1)));
+    }
+
+    /** Follows the loudest of the channels and returns how much of the tremolo to apply
+        at each sample, between 0 and 1. */
+    const Type* process(const Type* const* channels, int numChannels, int numSamples) noexcept
+    {
+        jassert(numSamples <= (int)amounts.size());
+        auto* levels = amounts.data();
+
+        rectifyLoudest(levels, scratch.data(), channels, numChannels, 0, numSamples);
+
+        // the smoothing is recursive so it runs sample by sample, but only once whatever the channels
+        for (int i = 0; i < numSamples; i++)
+        {
+            const auto x = levels[i];
+            envelope += (x > envelope ? attack : release) * (x - envelope);
+            levels[i] = envelope;
+        }
+
+        // straight from the threshold up to full depth, in amplitude so there is no log per sample
+        juce::FloatVectorOperations::add(levels, -threshold, numSamples);
+        juce::FloatVectorOperations::multiply(levels, inverseRange, numSamples);
+        juce::FloatVectorOperations::clip(levels, levels, Type(0), Type(1), numSamples);
+
+        return levels;
+    }
+
+private:
+    double sampleRate = 44.1e3;
+
+    std::vector<Type> amounts, scratch;
+
+    Type attackTime{ 10 }, releaseTime{ 250 }; // in milliseconds
+    Type attack{ 0 }, release{ 0 };
+    Type envelope{ 0 };
+
+    Type thresholdDecibels{ 1 }; // out of range, so the first setThreshold() always works it out
+    Type threshold{ 1 }, inverseRange{ 1 };
+
+    void updateCoefficients() noexcept
+    {
+        attack  = (Type)(1.0 - std::exp(-1000.0 / ((double)attackTime  * sampleRate)));
+        release = (Type)(1.0 - std::exp(-1000.0 / ((double)releaseTime * sampleRate)));
+    }
+};
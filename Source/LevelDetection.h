@@ -0,0 +1,30 @@
+/*
+  ==============================================================================
+
+    LevelDetection.h
+    Created: 19 Oct 2026 9:02:37pm
+    Author:  James Muten
+    The rectifier shared by the sidechain transient detector and the
+    dynamic mode's envelope follower, both of which follow the loudest
+    of their channels.
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+
+/** Rectifies the channels from the offset on and keeps the loudest of them at each sample in
+    levels, a vector operation per channel. scratch has to hold numSamples as well, and what is
+    left in it afterwards isn't needed. */
+template <typename Type>
+void rectifyLoudest(Type* levels, Type* scratch, const Type* const* channels, int numChannels,
+                    int offset, int numSamples) noexcept
+{
+    juce::FloatVectorOperations::abs(levels, channels[0] + offset, numSamples);
+    for (int channel = 1; channel < numChannels; channel++)
+    {
+        juce::FloatVectorOperations::abs(scratch, channels[channel] + offset, numSamples);
+        juce::FloatVectorOperations::max(levels, levels, scratch, numSamples);
+    }
+}
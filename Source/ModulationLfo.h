@@ -0,0 +1,40 @@
+/*
+  ==============================================================================
+
+    ModulationLfo.h
+    Created: 19 Oct 2026 5:03:41pm
+    Author:  James Muten
+    A slow sine LFO for moving the depth and speed of the main waves. It is
+    only read every few samples, and the waves ramp between the readings.
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+#include <cmath>
+
+class ModulationLfo
+{
+public:
+    void setRate(double rateHz, double sampleRate) noexcept
+    {
+        increment = rateHz / sampleRate;
+    }
+
+    void reset() noexcept
+    {
+        phase = 0.0;
+    }
+
+    // Moves on by the number of samples and returns the value there, between -1 and 1
+    float advance(int numSamples) noexcept
+    {
+        phase = std::fmod(phase + numSamples * increment, 1.0);
+        return (float)std::sin(juce::MathConstants<double>::twoPi * phase);
+    }
+
+private:
+    double phase = 0.0;
+    double increment = 0.0;
+};
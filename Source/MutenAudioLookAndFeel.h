@@ -10,6 +10,7 @@
 #pragma once
 
 #include <JuceHeader.h>
+#include <map>
 
 class MutenAudioLookAndFeel : public juce::LookAndFeel_V4
 {
@@ -30,6 +31,7 @@ public:
         primary = newPrimary;
         secondary = newSecondary;
         tertiary = newTertiary;
+        dialFaces.clear();
     }
 
     void drawRotarySlider(juce::Graphics& g, int x, int y, int width, int height, float sliderPos,
@@ -43,13 +45,13 @@ public:
         auto rw = radius * 2.0f;
         auto angle = rotaryStartAngle + sliderPos * (rotaryEndAngle - rotaryStartAngle);
 
-        // fill
-        g.setColour(tertiary);
-        g.fillEllipse(rx, ry, rw, rw);
+        if (radius <= 0.0f)
+            return;
 
-        // outline
-        g.setColour(secondary);
-        g.drawEllipse(rx, ry, rw, rw, 2.0f);
+        // the fill and outline never move, so they come from an image drawn once for the size
+        g.setOpacity(1.0f);
+        const auto& face = getDialFace(radius, g.getInternalContext().getPhysicalPixelScaleFactor());
+        g.drawImage(face, juce::Rectangle<float>(rx - faceMargin, ry - faceMargin, rw + 2.0f * faceMargin, rw + 2.0f * faceMargin));
 
         juce::Path p;
         auto pointerLength = radius * 0.33f;
@@ -161,4 +163,40 @@ private:
     juce::Colour primary = juce::Colours::black;
     juce::Colour secondary = juce::Colours::blue;
     juce::Colour tertiary = juce::Colours::red;
+
+    // dial faces by their size in physical pixels and the scale, all the dials are usually one size
+    static constexpr float faceMargin = 2.0f; // room for the outline around the radius
+    static constexpr size_t maxDialFaces = 8;
+    std::map<std::pair<int, int>, juce::Image> dialFaces;
+
+    const juce::Image& getDialFace(float radius, float scale)
+    {
+        const auto logicalSize = 2.0f * (radius + faceMargin);
+        const auto pixelSize   = juce::jmax(1, juce::roundToInt(logicalSize * scale));
+        const auto key = std::make_pair(pixelSize, juce::roundToInt(scale * 100.0f));
+
+        auto found = dialFaces.find(key);
+        if (found != dialFaces.end())
+            return found->second;
+
+        // dragging the window size makes a face for every size on the way, only the latest are kept
+        if (dialFaces.size() >= maxDialFaces)
+            dialFaces.clear();
+
+        juce::Image face(juce::Image::ARGB, pixelSize, pixelSize, true);
+        {
+            juce::Graphics g(face);
+            g.addTransform(juce::AffineTransform::scale((float)pixelSize / logicalSize));
+
+            // fill
+            g.setColour(tertiary);
+            g.fillEllipse(faceMargin, faceMargin, 2.0f * radius, 2.0f * radius);
+
+            // outline
+            g.setColour(secondary);
+            g.drawEllipse(faceMargin, faceMargin, 2.0f * radius, 2.0f * radius, 2.0f);
+        }
+
+        return dialFaces.emplace(key, std::move(face)).first->second;
+    }
 };
@@ -12,6 +12,7 @@
 
 VisualComponent::VisualComponent()
 {
+    setOpaque(true); // the background is always filled, so nothing behind needs painting
     // initialise the function vector 
     //displayValues[0] = { 0.0f, 1.0f };
     //displayValues[1] = { 0.0f, 1.0f };
@@ -19,7 +20,8 @@ VisualComponent::VisualComponent()
 
 void VisualComponent::paint(juce::Graphics& g)
 {
-    auto borderThickness = 5;
+    WAVES_TRACE_SCOPE("VisualComponent::paint");
+
     g.setColour (juce::Colours::darkgrey);
     g.fillRect  (0, 0, getWidth(), getHeight());
 
@@ -66,6 +68,30 @@ void VisualComponent::paint(juce::Graphics& g)
 
     g.setColour(secondary);
     g.strokePath(pathLeft, juce::PathStrokeType(lineThickness));
+
+    if (! editingShape)
+        return;
+
+    // the custom shape at full depth with its peak in the middle, and the points that can be dragged
+    juce::Path shapePath;
+    shapePath.startNewSubPath(shapeToScreen({ 0.0f, customShape.evaluate(0.0f) }));
+    for (int i = 1; i <= numPlotPoints; i++)
+    {
+        auto x = (float)i / numPlotPoints;
+        shapePath.lineTo(shapeToScreen({ x, customShape.evaluate(x) }));
+    }
+
+    g.setColour(primary);
+    g.strokePath(shapePath, juce::PathStrokeType(1.0f));
+
+    for (auto point : customShape.getPoints())
+    {
+        auto centre = shapeToScreen(point);
+        g.setColour(primary);
+        g.fillEllipse(centre.x - 4.0f, centre.y - 4.0f, 8.0f, 8.0f);
+        g.setColour(secondary);
+        g.drawEllipse(centre.x - 4.0f, centre.y - 4.0f, 8.0f, 8.0f, 1.5f);
+    }
 }
 
 void VisualComponent::resized()
@@ -75,7 +101,104 @@ void VisualComponent::resized()
 
 void VisualComponent::setLevels(const int channel, std::vector<float> values)
 {
-    displayValues[channel] = values;
+    // only repainted when the waves have changed, the timer asks far more often than that
+    if (values == displayValues[channel])
+        return;
+
+    displayValues[channel] = std::move(values);
+    repaint();
+}
+
+void VisualComponent::setCustomShape(const std::vector<juce::Point<float>>& points)
+{
+    customShape.setPoints(points);
+    repaint();
+}
+
+void VisualComponent::setShapeEditing(bool shouldEdit)
+{
+    if (editingShape != shouldEdit)
+    {
+        editingShape = shouldEdit;
+        draggedPoint = -1;
+        repaint();
+    }
+}
+
+juce::Point<float> VisualComponent::shapeToScreen(juce::Point<float> point) const
+{
+    auto screenWidth  = (float)(getWidth()  - 2 * borderThickness);
+    auto screenHeight = (float)(getHeight() - 2 * borderThickness);
+    return { borderThickness + point.x * screenWidth, getHeight() - borderThickness - point.y * screenHeight };
+}
+
+juce::Point<float> VisualComponent::screenToShape(juce::Point<float> position) const
+{
+    auto screenWidth  = (float)juce::jmax(1, getWidth()  - 2 * borderThickness);
+    auto screenHeight = (float)juce::jmax(1, getHeight() - 2 * borderThickness);
+    return { juce::jlimit(0.0f, 1.0f, (position.x - borderThickness) / screenWidth),
+             juce::jlimit(0.0f, 1.0f, (getHeight() - borderThickness - position.y) / screenHeight) };
+}
+
+int VisualComponent::findPointAt(juce::Point<float> position) const
+{
+    const auto& points = customShape.getPoints();
+    for (int i = 0; i < (int)points.size(); i++)
+        if (shapeToScreen(points[(size_t)i]).getDistanceFrom(position) < 8.0f)
+            return i;
+
+    return -1;
+}
+
+void VisualComponent::shapeChanged(std::vector<juce::Point<float>> points)
+{
+    customShape.setPoints(std::move(points));
+    repaint();
+
+    if (onShapeChanged)
+        onShapeChanged(customShape.getPoints());
+}
+
+void VisualComponent::mouseDown(const juce::MouseEvent& event)
+{
+    if (editingShape)
+        draggedPoint = findPointAt(event.position);
+}
+
+void VisualComponent::mouseDrag(const juce::MouseEvent& event)
+{
+    if (! editingShape || draggedPoint < 0)
+        return;
+
+    // the points are kept sorted, so follow the dragged one to wherever it ends up
+    auto points = customShape.getPoints();
+    auto position = screenToShape(event.position);
+    points[(size_t)draggedPoint] = position;
+    shapeChanged(points);
+    draggedPoint = findPointAt(shapeToScreen(position));
+}
+
+void VisualComponent::mouseUp(const juce::MouseEvent&)
+{
+    draggedPoint = -1;
+}
+
+void VisualComponent::mouseDoubleClick(const juce::MouseEvent& event)
+{
+    if (! editingShape)
+        return;
+
+    // double click on a point to remove it, or anywhere else to add one
+    auto points = customShape.getPoints();
+    auto index = findPointAt(event.position);
+
+    if (index >= 0)
+        points.erase(points.begin() + index);
+    else
+        points.push_back(screenToShape(event.position));
+
+    draggedPoint = -1;
+    shapeChanged(points);
 }
 
 void VisualComponent::setColours(juce::Colour newPrimary, juce::Colour newSecondary, juce::Colour newTertiary)
@@ -90,6 +213,54 @@ void CoverComponent::paint(juce::Graphics& g)
     g.fillAll(coverColour.withAlpha(0.5f));
 }
 
+FunctionSymbolsComponent::FunctionSymbolsComponent()
+{
+    // drawn once for each size and scale and kept, as the symbols never change
+    setBufferedToImage(true);
+    setInterceptsMouseClicks(false, false);
+}
+
+void FunctionSymbolsComponent::setColour(juce::Colour newColour)
+{
+    colour = newColour;
+    repaint();
+}
+
+void FunctionSymbolsComponent::paint(juce::Graphics& g)
+{
+    // Gaussian on top, then sine, then linear, level with the slider positions
+    const auto rowHeight = getHeight() / 3.0f;
+    const auto width     = (float)getWidth();
+    const auto thickness = juce::jmax(1.0f, rowHeight * 0.1f);
+    const auto margin    = thickness;
+    const int numPoints  = 32;
+
+    auto drawDip = [&](int row, auto&& shape)
+    {
+        const auto top    = row * rowHeight + margin;
+        const auto height = rowHeight - 2.0f * margin;
+
+        juce::Path path;
+        for (int i = 0; i <= numPoints; i++)
+        {
+            const auto x = (float)i / numPoints;
+            const juce::Point<float> point { margin + x * (width - 2.0f * margin), top + shape(x) * height };
+
+            if (i == 0)
+                path.startNewSubPath(point);
+            else
+                path.lineTo(point);
+        }
+
+        g.strokePath(path, juce::PathStrokeType(thickness, juce::PathStrokeType::curved, juce::PathStrokeType::rounded));
+    };
+
+    g.setColour(colour);
+    drawDip(0, [](float x) { return std::exp(-(x - 0.5f) * (x - 0.5f) / 0.02f); });
+    drawDip(1, [](float x) { return 0.5f - 0.5f * std::cos(juce::MathConstants<float>::twoPi * x); });
+    drawDip(2, [](float x) { return 1.0f - std::abs(2.0f * x - 1.0f); });
+}
+
 LabelComponent::LabelComponent()
 {
     // define the four labels
@@ -118,6 +289,8 @@ LabelComponent::LabelComponent()
     functionLabel.setJustificationType(juce::Justification::centred);
     addAndMakeVisible(functionLabel);
 
+    // the labels only change with the size, so they are drawn once for it and kept
+    setBufferedToImage(true);
 }
 
 void LabelComponent::paint(juce::Graphics& g)
@@ -132,6 +305,10 @@ void LabelComponent::resized()
     auto labelWidth = getWidth() / 4;
     auto labelHeightPos = getHeight() * 0.1;
 
+    // the text grows with the window
+    for (auto* label : { &depthLabel, &peakTimeLabel, &speedLabel, &functionLabel })
+        label->setFont(juce::Font(juce::FontOptions((float)labelHeight * 0.6f)));
+
     depthLabel.setBounds     (labelHorizontalBorder,                  labelHeightPos, labelWidth - 2 * labelHorizontalBorder, labelHeight);
     peakTimeLabel.setBounds  (labelHorizontalBorder + 1 * labelWidth, labelHeightPos, labelWidth - 2 * labelHorizontalBorder, labelHeight);
     speedLabel.setBounds (labelHorizontalBorder + 2 * labelWidth, labelHeightPos, labelWidth - 2 * labelHorizontalBorder, labelHeight);
@@ -139,19 +316,57 @@ void LabelComponent::resized()
 }
 
 //==============================================================================
+namespace
+{
+    // decoded images stay in the cache this long after the last editor using them closes
+    constexpr int imageCacheTimeoutMs = 60000;
+
+    /** An image from BinaryData at the size it is drawn in the bounds, in physical pixels, so painting it
+        is a straight copy. The decoded image and each scaled copy are kept in the ImageCache, so they are
+        shared by every editor and opening another window doesn't decode or scale anything again. */
+    juce::Image getScaledImage(const void* data, int dataSize, juce::Rectangle<int> bounds, float scale)
+    {
+        auto image = juce::ImageCache::getFromMemory(data, dataSize);
+        if (image.isNull() || bounds.isEmpty())
+            return image;
+
+        // fitted the way the ImageComponent places it, keeping the aspect ratio
+        const auto fitted = juce::RectanglePlacement(juce::RectanglePlacement::centred)
+                                .appliedTo(image.getBounds().toFloat(), bounds.toFloat() * scale);
+        const auto width  = juce::jmax(1, juce::roundToInt(fitted.getWidth()));
+        const auto height = juce::jmax(1, juce::roundToInt(fitted.getHeight()));
+
+        const auto hash = (juce::String::toHexString((juce::pointer_sized_int)data) + "_"
+                           + juce::String(width) + "x" + juce::String(height)).hashCode64();
+
+        auto scaled = juce::ImageCache::getFromHashCode(hash);
+        if (scaled.isNull())
+        {
+            scaled = image.rescaled(width, height, juce::Graphics::highResamplingQuality);
+            juce::ImageCache::addImageToCache(scaled, hash);
+        }
+
+        return scaled;
+    }
+}
+
 WavesAudioProcessorEditor::WavesAudioProcessorEditor (WavesAudioProcessor& p, juce::AudioProcessorValueTreeState& vts)
     : AudioProcessorEditor (&p), audioProcessor (p)
 {
+    WAVES_TRACE_SCOPE("WavesAudioProcessorEditor");
+
     setLookAndFeel (&wavesLookAndFeel);
     wavesLookAndFeel.setColours(primary, secondary, tertiary);
+    setOpaque(true);
 
+    // the layout is all proportions of the window, so it scales to any size as long as the shape stays
     setResizable(true, true);
 
     const juce::Displays::Display* screen = juce::Desktop::getInstance().getDisplays().getPrimaryDisplay();
     int displayWidth = screen->totalArea.getWidth();
     int displayHeight = screen->totalArea.getHeight();
-    setResizeLimits(100, 100, displayWidth, displayHeight);
-    setSize (800, 600);
+    setResizeLimits(400, 300, displayWidth, displayHeight);
+    getConstrainer()->setFixedAspectRatio(defaultWidth / (double) defaultHeight);
 
     // LEFT CHANNEL SLIDERS
     addAndMakeVisible(depthLeftSlider);
@@ -259,6 +474,77 @@ WavesAudioProcessorEditor::WavesAudioProcessorEditor (WavesAudioProcessor& p, ju
     monoStereoSelector.setPopupDisplayEnabled(false, false, this);
     //monoStereoSelector.setValue(0);
 
+    // custom shape switches, the right one follows the left in mono like the sliders do
+    addAndMakeVisible(customShapeLeftButton);
+    customShapeLeftButton.setClickingTogglesState(true);
+    customShapeLeftButton.setColour(juce::TextButton::buttonColourId, primary);
+    customShapeLeftButton.setColour(juce::TextButton::buttonOnColourId, tertiary);
+    customShapeLeftAttachment.reset(new juce::AudioProcessorValueTreeState::ButtonAttachment(vts, "cuL", customShapeLeftButton));
+    customShapeLeftButton.onClick = [this]
+    {
+        if (stereo == 0)
+            customShapeRightButton.setToggleState(customShapeLeftButton.getToggleState(), juce::sendNotification);
+    };
+
+    addAndMakeVisible(customShapeRightButton);
+    customShapeRightButton.setClickingTogglesState(true);
+    customShapeRightButton.setColour(juce::TextButton::buttonColourId, primary);
+    customShapeRightButton.setColour(juce::TextButton::buttonOnColourId, tertiary);
+    customShapeRightAttachment.reset(new juce::AudioProcessorValueTreeState::ButtonAttachment(vts, "cuR", customShapeRightButton));
+
+    // audio rate switch, the speed dials read in Hz while it is on
+    addAndMakeVisible(audioRateButton);
+    audioRateButton.setClickingTogglesState(true);
+    audioRateButton.setColour(juce::TextButton::buttonColourId, primary);
+    audioRateButton.setColour(juce::TextButton::buttonOnColourId, tertiary);
+    audioRateAttachment.reset(new juce::AudioProcessorValueTreeState::ButtonAttachment(vts, "ar", audioRateButton));
+
+    // morph between two stored snapshots of the dials, the A and B buttons store the current dials
+    addAndMakeVisible(morphButton);
+    morphButton.setClickingTogglesState(true);
+    morphButton.setColour(juce::TextButton::buttonColourId, primary);
+    morphButton.setColour(juce::TextButton::buttonOnColourId, tertiary);
+    morphOnAttachment.reset(new juce::AudioProcessorValueTreeState::ButtonAttachment(vts, "mon", morphButton));
+
+    for (auto* button : { &storeMorphAButton, &storeMorphBButton })
+    {
+        addAndMakeVisible(button);
+        button->setColour(juce::TextButton::buttonColourId, primary);
+    }
+    storeMorphAButton.onClick = [this] { audioProcessor.storeMorphSnapshot(0); };
+    storeMorphBButton.onClick = [this] { audioProcessor.storeMorphSnapshot(1); };
+
+    addAndMakeVisible(morphSlider);
+    morphSlider.setSliderStyle(juce::Slider::LinearHorizontal);
+    morphAttachment.reset(new juce::AudioProcessorValueTreeState::SliderAttachment(vts, "mph", morphSlider));
+    morphSlider.setTextBoxStyle(juce::Slider::NoTextBox, false, 50, 20);
+
+    // oversampling selector, off / 2x / 4x
+    addAndMakeVisible(oversamplingSelector);
+    oversamplingSelector.setSliderStyle(juce::Slider::LinearHorizontal);
+    oversamplingAttachment.reset(new juce::AudioProcessorValueTreeState::SliderAttachment(vts, "os", oversamplingSelector));
+    oversamplingSelector.setTextBoxStyle(juce::Slider::NoTextBox, false, 50, 20);
+    oversamplingSelector.setPopupDisplayEnabled(false, false, this);
+
+    oversamplingLabel.setText("Off / 2x / 4x", juce::dontSendNotification);
+    oversamplingLabel.setColour(juce::Label::textColourId, juce::Colours::black);
+    oversamplingLabel.setColour(juce::Label::backgroundColourId, primary);
+    oversamplingLabel.setJustificationType(juce::Justification::centred);
+    addAndMakeVisible(oversamplingLabel);
+
+    // stereo offset, only used in mono where the right channel plays the left channel's wave further on
+    addAndMakeVisible(stereoOffsetSlider);
+    stereoOffsetSlider.setSliderStyle(juce::Slider::LinearHorizontal);
+    stereoOffsetAttachment.reset(new juce::AudioProcessorValueTreeState::SliderAttachment(vts, "sof", stereoOffsetSlider));
+    stereoOffsetSlider.setTextBoxStyle(juce::Slider::NoTextBox, false, 50, 20);
+    stereoOffsetSlider.setPopupDisplayEnabled(true, false, this);
+
+    stereoOffsetLabel.setText("Stereo Offset", juce::dontSendNotification);
+    stereoOffsetLabel.setColour(juce::Label::textColourId, juce::Colours::black);
+    stereoOffsetLabel.setColour(juce::Label::backgroundColourId, primary);
+    stereoOffsetLabel.setJustificationType(juce::Justification::centred);
+    addAndMakeVisible(stereoOffsetLabel);
+
     // all listeners
     depthLeftSlider.addListener(this);
     speedLeftSlider.addListener(this);
@@ -266,6 +552,7 @@ WavesAudioProcessorEditor::WavesAudioProcessorEditor (WavesAudioProcessor& p, ju
     firstFunctionLeftSlider.addListener(this);
     secondFunctionLeftSlider.addListener(this);
     monoStereoSelector.addListener(this);
+    sliderValueChanged(&monoStereoSelector); // so the cover and the offset match the mono/stereo setting from the start
 
     // mono stereo label
     monoLabel.setText("Mono / Stereo", juce::dontSendNotification);
@@ -277,24 +564,31 @@ WavesAudioProcessorEditor::WavesAudioProcessorEditor (WavesAudioProcessor& p, ju
     addAndMakeVisible(labelDisplay);
     addAndMakeVisible(wavesDisplay);
     wavesDisplay.setColours(primary, secondary, tertiary);
+    wavesDisplay.setCustomShape(audioProcessor.getCustomShape());
+    wavesDisplay.onShapeChanged = [this](const std::vector<juce::Point<float>>& points) { audioProcessor.setCustomShape(points); };
     addAndMakeVisible(monoCover); // making a child component
 
-    // load logo image
-    logoImage = juce::ImageFileFormat::loadFrom(BinaryData::waveslogo_png, BinaryData::waveslogo_pngSize);
-    logoComponent.setImage(logoImage);
+    // the logo is set in resized(), scaled for where it goes
+    juce::ImageCache::setCacheTimeout(imageCacheTimeoutMs);
     addAndMakeVisible(logoComponent);
 
-    // load function images
-    functionImageLeft = juce::ImageFileFormat::loadFrom(BinaryData::wavesFunctionSymbols_png, BinaryData::wavesFunctionSymbols_pngSize);
-    functionComponentLeft.setImage(functionImageLeft);
+    functionComponentLeft.setColour(secondary);
+    functionComponentRight.setColour(tertiary);
     addAndMakeVisible(functionComponentLeft);
-
-    functionImageRight = juce::ImageFileFormat::loadFrom(BinaryData::wavesFunctionSymbolsAlt_png, BinaryData::wavesFunctionSymbolsAlt_pngSize);
-    functionComponentRight.setImage(functionImageRight);
     addAndMakeVisible(functionComponentRight);
 
+    // sized last so everything is laid out once, with all the children there
+    setSize (defaultWidth, defaultHeight);
+
+    // the waves are there for the first paint rather than a timer tick later
+    timerCallback();
+
     // timer to retreive values from the processor
     startTimerHz(24);
+
+   #if WAVES_TRACING
+    setWantsKeyboardFocus(true); // for the shortcut that writes the trace
+   #endif
 }
 
 WavesAudioProcessorEditor::~WavesAudioProcessorEditor()
@@ -316,6 +610,7 @@ void WavesAudioProcessorEditor::sliderValueChanged(juce::Slider* slider)
         speedRightSlider.setValue (speedLeftSlider.getValue());
         firstFunctionRightSlider.setValue (firstFunctionLeftSlider.getValue());
         secondFunctionRightSlider.setValue (secondFunctionLeftSlider.getValue());
+        customShapeRightButton.setToggleState (customShapeLeftButton.getToggleState(), juce::sendNotification);
 
         monoCover.setVisible(true);
     }
@@ -323,6 +618,8 @@ void WavesAudioProcessorEditor::sliderValueChanged(juce::Slider* slider)
     {
         monoCover.setVisible(false);
     }
+
+    stereoOffsetSlider.setEnabled(stereo == 0);
 }
 
 //==============================================================================
@@ -352,6 +649,11 @@ void WavesAudioProcessorEditor::resized()
     auto controlsHeightRight = getHeight() - dialHeight;
     auto controlsHeightLeft = controlsHeightRight - dialHeight;
 
+    // the dial readouts grow with the window too
+    const auto uiScale = getWidth() / (float) defaultWidth;
+    for (auto* dial : { &depthLeftSlider, &peakTimeLeftSlider, &speedLeftSlider, &depthRightSlider, &peakTimeRightSlider, &speedRightSlider })
+        dial->setTextBoxStyle(juce::Slider::TextBoxBelow, false, juce::roundToInt(50 * uiScale), juce::roundToInt(20 * uiScale));
+
     depthLeftSlider.setBounds     (dialXPos,                   controlsHeightLeft, dialWidth - border, dialHeight - border);
     peakTimeLeftSlider.setBounds  (dialXPos + dialSpacing,     controlsHeightLeft, dialWidth - border, dialHeight - border);
     speedLeftSlider.setBounds (dialXPos + 2 * dialSpacing, controlsHeightLeft, dialWidth - border, dialHeight - border);
@@ -380,6 +682,11 @@ void WavesAudioProcessorEditor::resized()
     firstFunctionRightSlider. setBounds (3 * dialSpacing + funcWidth,     controlsHeightRight + dialHeight * 0.1, funcWidth, funcHeight);
     secondFunctionRightSlider.setBounds (4 * dialSpacing - 2 * funcWidth, controlsHeightRight + dialHeight * 0.1, funcWidth, funcHeight);
 
+    // custom shape switches sit under the function sliders
+    auto customHeight = dialHeight * 0.2;
+    customShapeLeftButton.setBounds  (3 * dialSpacing + funcWidth, controlsHeightLeft  + dialHeight * 0.72, dialSpacing - 2 * funcWidth, customHeight);
+    customShapeRightButton.setBounds (3 * dialSpacing + funcWidth, controlsHeightRight + dialHeight * 0.72, dialSpacing - 2 * funcWidth, customHeight);
+
     //functionGaussRightLabel.setBounds   (3.5 * dialSpacing - 0.5 * funcLabelWidth, controlsHeightRight + 0.1 * dialHeight,                       funcLabelWidth, funcLabelHeight);
     //functionSineRightLabel.setBounds    (3.5 * dialSpacing - 0.5 * funcLabelWidth, controlsHeightRight + 0.1 * dialHeight + funcLabelHeight,     funcLabelWidth, funcLabelHeight);
     //functionLinearRightLabel.setBounds  (3.5 * dialSpacing - 0.5 * funcLabelWidth, controlsHeightRight + 0.1 * dialHeight + 2 * funcLabelHeight, funcLabelWidth, funcLabelHeight);
@@ -401,6 +708,27 @@ void WavesAudioProcessorEditor::resized()
     // mono/stereo label
     monoLabel.setBounds(monoXBorder, monoYPos - monoHeight / 2, dialSpacing / 2, labelHeight);
 
+    // audio rate switch mirrors the mono/stereo selector on the other side of the display
+    audioRateButton.setBounds(getWidth() - monoXBorder - dialSpacing / 2, monoYPos, dialSpacing / 2, monoHeight);
+
+    // the morph controls run along the bottom of the display
+    auto morphX      = getWidth() / 4;
+    auto morphY      = labelYPos * 0.82;
+    auto morphWidth  = getWidth() / 2;
+    auto morphHeight = labelYPos * 0.12;
+    morphButton.setBounds      (morphX,                      morphY, morphWidth * 0.2,  morphHeight);
+    storeMorphAButton.setBounds(morphX + morphWidth * 0.22,  morphY, morphWidth * 0.1,  morphHeight);
+    morphSlider.setBounds      (morphX + morphWidth * 0.33,  morphY, morphWidth * 0.54, morphHeight);
+    storeMorphBButton.setBounds(morphX + morphWidth * 0.9,   morphY, morphWidth * 0.1,  morphHeight);
+
+    // stereo offset and its label sit above the mono/stereo selector, mirroring the oversampling selector
+    stereoOffsetSlider.setBounds(monoXBorder, monoYPos - 1.5 * monoHeight, dialSpacing / 2, monoHeight);
+    stereoOffsetLabel.setBounds(monoXBorder, monoYPos - 2 * monoHeight, dialSpacing / 2, labelHeight);
+
+    // oversampling selector and its label sit above the audio rate switch
+    oversamplingSelector.setBounds(getWidth() - monoXBorder - dialSpacing / 2, monoYPos - 1.5 * monoHeight, dialSpacing / 2, monoHeight);
+    oversamplingLabel.setBounds(getWidth() - monoXBorder - dialSpacing / 2, monoYPos - 2 * monoHeight, dialSpacing / 2, labelHeight);
+
     // faint grey box to cover stereo controls in mono
     monoCover.setBounds (0, controlsHeightRight, getWidth(), dialHeight);
 
@@ -411,12 +739,40 @@ void WavesAudioProcessorEditor::resized()
     auto logoWidth = dialWidth;
     logoComponent.setBounds(logoXPos, logoYPos, logoWidth, logoHeight);
 
+    updateImages();
 }
 
+void WavesAudioProcessorEditor::updateImages()
+{
+    const auto scale = juce::Component::getApproximateScaleFactorForComponent(this);
+
+    logoComponent.setImage(getScaledImage(BinaryData::waveslogo_png, BinaryData::waveslogo_pngSize,
+                                          logoComponent.getLocalBounds(), scale));
+}
+
+
+#if WAVES_TRACING
+bool WavesAudioProcessorEditor::keyPressed(const juce::KeyPress& key)
+{
+    // ctrl/cmd + shift + T writes what the trace buffers hold to the desktop
+    if (key == juce::KeyPress('t', juce::ModifierKeys::commandModifier | juce::ModifierKeys::shiftModifier, 0))
+    {
+        const auto file = juce::File::getSpecialLocation(juce::File::userDesktopDirectory)
+                              .getNonexistentChildFile("Waves trace " + juce::Time::getCurrentTime().formatted("%Y-%m-%d %H-%M-%S"), ".json");
+        TraceRecorder::getInstance().writeChromeTrace(file);
+        return true;
+    }
+
+    return false;
+}
+#endif
 
 void WavesAudioProcessorEditor::timerCallback()
 {
+    WAVES_TRACE_SCOPE("timerCallback");
+
+    wavesDisplay.setShapeEditing(customShapeLeftButton.getToggleState() || customShapeRightButton.getToggleState());
+
     wavesDisplay.setLevels(0, audioProcessor.getFunctionValues(0)); // get the function values 
     wavesDisplay.setLevels(1, audioProcessor.getFunctionValues(1)); // get the function values 
-    wavesDisplay.repaint();
 }
\ No newline at end of file
@@ -23,6 +23,16 @@ public:
     void setLevels(const int channel, std::vector<float> values);
     void setColours(juce::Colour newPrimary, juce::Colour newSecondary, juce::Colour newTertiary);
 
+    // the custom shape is drawn over the waves and can be edited with the mouse while it is in use
+    void setCustomShape(const std::vector<juce::Point<float>>& points);
+    void setShapeEditing(bool shouldEdit);
+    std::function<void(const std::vector<juce::Point<float>>&)> onShapeChanged;
+
+    void mouseDown(const juce::MouseEvent&) override;
+    void mouseDrag(const juce::MouseEvent&) override;
+    void mouseUp(const juce::MouseEvent&) override;
+    void mouseDoubleClick(const juce::MouseEvent&) override;
+
 private:
     //==============================================================================
     // colour scheme for visual component
@@ -32,6 +42,17 @@ private:
 
     std::vector<std::vector<float>> displayValues{{0, 1}, {0, 1}};
 
+    static constexpr int borderThickness = 5;
+
+    CustomShape customShape;
+    bool editingShape = false;
+    int draggedPoint = -1;
+
+    juce::Point<float> shapeToScreen(juce::Point<float> point) const;
+    juce::Point<float> screenToShape(juce::Point<float> position) const;
+    int findPointAt(juce::Point<float> position) const;
+    void shapeChanged(std::vector<juce::Point<float>> points);
+
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(VisualComponent)
 };
 
@@ -57,6 +78,21 @@ private:
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(CoverComponent)
 };
 
+//==============================================================================
+// the Gaussian, sine and linear symbols next to the function sliders, drawn as paths so they are sharp at any size
+class FunctionSymbolsComponent : public juce::Component
+{
+public:
+    FunctionSymbolsComponent();
+    void paint(juce::Graphics&) override;
+    void setColour(juce::Colour newColour);
+
+private:
+    juce::Colour colour = juce::Colours::black;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(FunctionSymbolsComponent)
+};
+
 //==============================================================================
 class LabelComponent : public juce::Component
 {
@@ -92,18 +128,28 @@ public:
     int stereo = 0;
     void timerCallback() override;
 
+   #if WAVES_TRACING
+    bool keyPressed(const juce::KeyPress& key) override;
+   #endif
+
 private:
     void sliderValueChanged(juce::Slider* slider) override;
     WavesAudioProcessor& audioProcessor;
     VisualComponent wavesDisplay; // new child component that contains the UI elements of the plugin
     LabelComponent  labelDisplay; // a separate area to label the dials
     juce::Label monoLabel; // make a temporary logo using a label just to get positioning right
+    juce::Label oversamplingLabel;
+    juce::Label stereoOffsetLabel;
     CoverComponent monoCover;
 
+    // the size the layout was drawn for, it keeps this shape at any size
+    static constexpr int defaultWidth = 800, defaultHeight = 600;
+
+    // the logo comes from the ImageCache, decoded once for every editor and scaled to its bounds
     juce::ImageComponent logoComponent;
-    juce::Image logoImage;
-    juce::ImageComponent functionComponentLeft, functionComponentRight;
-    juce::Image functionImageLeft, functionImageRight;
+    void updateImages();
+
+    FunctionSymbolsComponent functionComponentLeft, functionComponentRight;
 
     // colour scheme for the editor
     // primary colour in HSV is 207, or hex #98bbd9
@@ -117,6 +163,13 @@ private:
     juce::Slider firstFunctionLeftSlider, secondFunctionLeftSlider;
     juce::Slider firstFunctionRightSlider, secondFunctionRightSlider;
     juce::Slider monoStereoSelector;
+    juce::Slider oversamplingSelector;
+    juce::Slider stereoOffsetSlider;
+
+    juce::TextButton customShapeLeftButton { "Custom" }, customShapeRightButton { "Custom" };
+    juce::TextButton audioRateButton { "Audio Rate" };
+    juce::TextButton morphButton { "Morph" }, storeMorphAButton { "A" }, storeMorphBButton { "B" };
+    juce::Slider morphSlider;
 
     juce::Label functionLinearLeftLabel, functionSineLeftLabel, functionGaussLeftLabel;
     juce::Label functionLinearRightLabel, functionSineRightLabel, functionGaussRightLabel;
@@ -134,6 +187,14 @@ private:
     std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment> secondFunctionRightAttachment;
 
     std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment> monoStereoAttachment;
+    std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment> oversamplingAttachment;
+    std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment> stereoOffsetAttachment;
+
+    std::unique_ptr<juce::AudioProcessorValueTreeState::ButtonAttachment> customShapeLeftAttachment;
+    std::unique_ptr<juce::AudioProcessorValueTreeState::ButtonAttachment> customShapeRightAttachment;
+    std::unique_ptr<juce::AudioProcessorValueTreeState::ButtonAttachment> audioRateAttachment;
+    std::unique_ptr<juce::AudioProcessorValueTreeState::ButtonAttachment> morphOnAttachment;
+    std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment> morphAttachment;
 
 
     MutenAudioLookAndFeel wavesLookAndFeel; 
@@ -17,8 +17,10 @@ WavesAudioProcessor::WavesAudioProcessor()
                      #if ! JucePlugin_IsMidiEffect
                       #if ! JucePlugin_IsSynth
                        .withInput  ("Input",  juce::AudioChannelSet::stereo(), true)
+                       .withInput  ("Sidechain", juce::AudioChannelSet::stereo(), false)
                       #endif
                        .withOutput ("Output", juce::AudioChannelSet::stereo(), true)
+                       .withOutput ("Modulation", juce::AudioChannelSet::stereo(), false) // the gain curve, for other plugins to follow
                      #endif
                        ),
 #else
@@ -62,7 +64,162 @@ parameters(*this, nullptr, juce::Identifier ("wavesPlugin"),
 
       std::make_unique<juce::AudioParameterInt>("ffR", "First Function", 1, 3, 1),
       std::make_unique<juce::AudioParameterInt>("sfR", "SecondFunction", 1, 3, 1),
-      std::make_unique<juce::AudioParameterInt>("ms", "MonoStereo", 0, 1, 1)})
+      std::make_unique<juce::AudioParameterInt>("ms", "MonoStereo", 0, 1, 1),
+      std::make_unique<juce::AudioParameterFloat>("sof", "Stereo Offset", // how far the right channel runs ahead in mono
+                                                   juce::NormalisableRange<float>(0.0f, 360.0f, 1.0f),
+                                                   0.0f,
+                                                   juce::String(),
+                                                   juce::AudioProcessorParameter::genericParameter,
+                                                   [](float value, int) { return juce::String(value, 0) + juce::String(juce::CharPointer_UTF8("\xc2\xb0")); },
+                                                   [](const juce::String& text) { return text.getFloatValue(); }),
+
+      std::make_unique<juce::AudioParameterInt>("ar", "Audio Rate", 0, 1, 0), // speed dials read in Hz instead of bpm
+      std::make_unique<juce::AudioParameterInt>("os", "Oversampling", 0, 2, 0), // off, 2x, 4x
+      std::make_unique<juce::AudioParameterInt>("ctl", "Control Rate", 0, 1, 0), // slow waves ramp between points a few samples apart
+      std::make_unique<juce::AudioParameterInt>("cmp", "Compact Tables", 0, 1, 0), // per-sample tables kept as 16 bit codes
+
+      std::make_unique<juce::AudioParameterInt>("cuL", "Custom Shape", 0, 1, 0),
+      std::make_unique<juce::AudioParameterInt>("cuR", "Custom Shape", 0, 1, 0),
+
+      std::make_unique<juce::AudioParameterInt>("mrt", "MIDI Retrigger", 0, 1, 1),
+      std::make_unique<juce::AudioParameterInt>("msp", "MIDI Speed", 0, 3, 0), // off, note, mod wheel, clock
+
+      std::make_unique<juce::AudioParameterInt>("bnd", "Bands", 1, 4, 1), // 1 is the whole signal through the main waves
+      std::make_unique<juce::AudioParameterFloat>("xo1", "Crossover 1",
+                                                   juce::NormalisableRange<float>(20.0f, 20000.0f, 1.0f, 0.25f),
+                                                   200.0f,
+                                                   juce::String(),
+                                                   juce::AudioProcessorParameter::genericParameter,
+                                                   [](float value, int) { return juce::String(value, 0) + " Hz"; },
+                                                   [](const juce::String& text) { return text.getFloatValue(); }),
+      std::make_unique<juce::AudioParameterFloat>("xo2", "Crossover 2",
+                                                   juce::NormalisableRange<float>(20.0f, 20000.0f, 1.0f, 0.25f),
+                                                   1000.0f,
+                                                   juce::String(),
+                                                   juce::AudioProcessorParameter::genericParameter,
+                                                   [](float value, int) { return juce::String(value, 0) + " Hz"; },
+                                                   [](const juce::String& text) { return text.getFloatValue(); }),
+      std::make_unique<juce::AudioParameterFloat>("xo3", "Crossover 3",
+                                                   juce::NormalisableRange<float>(20.0f, 20000.0f, 1.0f, 0.25f),
+                                                   5000.0f,
+                                                   juce::String(),
+                                                   juce::AudioProcessorParameter::genericParameter,
+                                                   [](float value, int) { return juce::String(value, 0) + " Hz"; },
+                                                   [](const juce::String& text) { return text.getFloatValue(); }),
+
+      std::make_unique<juce::AudioParameterFloat>("dpB2", "Band 2 Depth",
+                                                   juce::NormalisableRange<float>(-20.0f, 20.0f, 0.01f),
+                                                   0.0f,
+                                                   juce::String(),
+                                                   juce::AudioProcessorParameter::genericParameter,
+                                                   [](float value, int) { return "-" + juce::String(std::abs(value), 1) + " dB"; },
+                                                   [](const juce::String& text) { return text.getFloatValue(); }),
+      std::make_unique<juce::AudioParameterFloat>("ptB2", "Band 2 Peak Time", 0.2f, 0.8f, 0.5f),
+      std::make_unique<juce::AudioParameterFloat>("spB2", "Band 2 Speed",
+                                                   juce::NormalisableRange<float>(60.0f, 480.0f, 1.0f),
+                                                   240.0f,
+                                                   juce::String(),
+                                                   juce::AudioProcessorParameter::genericParameter,
+                                                   [](float value, int) { return juce::String(value, 0) + " bpm"; },
+                                                   [](const juce::String& text) { return text.getFloatValue(); }),
+      std::make_unique<juce::AudioParameterInt>("ffB2", "Band 2 First Function", 1, 3, 1),
+      std::make_unique<juce::AudioParameterInt>("sfB2", "Band 2 Second Function", 1, 3, 1),
+
+      std::make_unique<juce::AudioParameterFloat>("dpB3", "Band 3 Depth",
+                                                   juce::NormalisableRange<float>(-20.0f, 20.0f, 0.01f),
+                                                   0.0f,
+                                                   juce::String(),
+                                                   juce::AudioProcessorParameter::genericParameter,
+                                                   [](float value, int) { return "-" + juce::String(std::abs(value), 1) + " dB"; },
+                                                   [](const juce::String& text) { return text.getFloatValue(); }),
+      std::make_unique<juce::AudioParameterFloat>("ptB3", "Band 3 Peak Time", 0.2f, 0.8f, 0.5f),
+      std::make_unique<juce::AudioParameterFloat>("spB3", "Band 3 Speed",
+                                                   juce::NormalisableRange<float>(60.0f, 480.0f, 1.0f),
+                                                   240.0f,
+                                                   juce::String(),
+                                                   juce::AudioProcessorParameter::genericParameter,
+                                                   [](float value, int) { return juce::String(value, 0) + " bpm"; },
+                                                   [](const juce::String& text) { return text.getFloatValue(); }),
+      std::make_unique<juce::AudioParameterInt>("ffB3", "Band 3 First Function", 1, 3, 1),
+      std::make_unique<juce::AudioParameterInt>("sfB3", "Band 3 Second Function", 1, 3, 1),
+
+      std::make_unique<juce::AudioParameterFloat>("dpB4", "Band 4 Depth",
+                                                   juce::NormalisableRange<float>(-20.0f, 20.0f, 0.01f),
+                                                   0.0f,
+                                                   juce::String(),
+                                                   juce::AudioProcessorParameter::genericParameter,
+                                                   [](float value, int) { return "-" + juce::String(std::abs(value), 1) + " dB"; },
+                                                   [](const juce::String& text) { return text.getFloatValue(); }),
+      std::make_unique<juce::AudioParameterFloat>("ptB4", "Band 4 Peak Time", 0.2f, 0.8f, 0.5f),
+      std::make_unique<juce::AudioParameterFloat>("spB4", "Band 4 Speed",
+                                                   juce::NormalisableRange<float>(60.0f, 480.0f, 1.0f),
+                                                   240.0f,
+                                                   juce::String(),
+                                                   juce::AudioProcessorParameter::genericParameter,
+                                                   [](float value, int) { return juce::String(value, 0) + " bpm"; },
+                                                   [](const juce::String& text) { return text.getFloatValue(); }),
+      std::make_unique<juce::AudioParameterInt>("ffB4", "Band 4 First Function", 1, 3, 1),
+      std::make_unique<juce::AudioParameterInt>("sfB4", "Band 4 Second Function", 1, 3, 1),
+
+      std::make_unique<juce::AudioParameterInt>("mon", "Morph On", 0, 1, 0),
+      std::make_unique<juce::AudioParameterFloat>("mph", "Morph", 0.0f, 1.0f, 0.0f), // snapshot A to snapshot B
+
+      std::make_unique<juce::AudioParameterInt>("lfo", "LFO On", 0, 1, 0), // the LFOs only move the waves, every band of them, when on
+      std::make_unique<juce::AudioParameterFloat>("l1r", "LFO 1 Rate",
+                                                   juce::NormalisableRange<float>(0.01f, 10.0f, 0.01f, 0.3f),
+                                                   0.2f,
+                                                   juce::String(),
+                                                   juce::AudioProcessorParameter::genericParameter,
+                                                   [](float value, int) { return juce::String(value, 2) + " Hz"; },
+                                                   [](const juce::String& text) { return text.getFloatValue(); }),
+      std::make_unique<juce::AudioParameterFloat>("l1d", "LFO 1 Depth", 0.0f, 1.0f, 0.0f), // how far it moves the main depth
+      std::make_unique<juce::AudioParameterFloat>("l1s", "LFO 1 Speed", 0.0f, 1.0f, 0.0f), // in octaves of the main speed
+      std::make_unique<juce::AudioParameterFloat>("l2r", "LFO 2 Rate",
+                                                   juce::NormalisableRange<float>(0.01f, 10.0f, 0.01f, 0.3f),
+                                                   0.05f,
+                                                   juce::String(),
+                                                   juce::AudioProcessorParameter::genericParameter,
+                                                   [](float value, int) { return juce::String(value, 2) + " Hz"; },
+                                                   [](const juce::String& text) { return text.getFloatValue(); }),
+      std::make_unique<juce::AudioParameterFloat>("l2d", "LFO 2 Depth", 0.0f, 1.0f, 0.0f), // how far it moves the main depth
+      std::make_unique<juce::AudioParameterFloat>("l2s", "LFO 2 Speed", 0.0f, 1.0f, 0.0f), // in octaves of the main speed
+
+      std::make_unique<juce::AudioParameterFloat>("rnd", "Randomise", 0.0f, 1.0f, 0.0f), // per-cycle variation
+      std::make_unique<juce::AudioParameterInt>("sed", "Random Seed", 1, 999, 1),
+
+      std::make_unique<juce::AudioParameterInt>("grp", "Sync Group", 0, SharedClock::numGroups, 0), // 0 runs free
+
+      std::make_unique<juce::AudioParameterInt>("dyn", "Dynamic Depth", 0, 1, 0), // the tremolo follows the input level
+      std::make_unique<juce::AudioParameterFloat>("dyT", "Dynamic Threshold",
+                                                   juce::NormalisableRange<float>(-60.0f, 0.0f, 0.1f),
+                                                   -30.0f,
+                                                   juce::String(),
+                                                   juce::AudioProcessorParameter::genericParameter,
+                                                   [](float value, int) { return juce::String(value, 1) + " dB"; },
+                                                   [](const juce::String& text) { return text.getFloatValue(); }),
+      std::make_unique<juce::AudioParameterFloat>("dyA", "Dynamic Attack",
+                                                   juce::NormalisableRange<float>(1.0f, 200.0f, 1.0f, 0.4f),
+                                                   10.0f,
+                                                   juce::String(),
+                                                   juce::AudioProcessorParameter::genericParameter,
+                                                   [](float value, int) { return juce::String(value, 0) + " ms"; },
+                                                   [](const juce::String& text) { return text.getFloatValue(); }),
+      std::make_unique<juce::AudioParameterFloat>("dyR", "Dynamic Release",
+                                                   juce::NormalisableRange<float>(10.0f, 2000.0f, 1.0f, 0.4f),
+                                                   250.0f,
+                                                   juce::String(),
+                                                   juce::AudioProcessorParameter::genericParameter,
+                                                   [](float value, int) { return juce::String(value, 0) + " ms"; },
+                                                   [](const juce::String& text) { return text.getFloatValue(); }),
+
+      std::make_unique<juce::AudioParameterInt>("sc", "Sidechain Trigger", 0, 1, 0),
+      std::make_unique<juce::AudioParameterFloat>("scT", "Trigger Threshold",
+                                                   juce::NormalisableRange<float>(1.0f, 24.0f, 0.1f),
+                                                   6.0f,
+                                                   juce::String(),
+                                                   juce::AudioProcessorParameter::genericParameter,
+                                                   [](float value, int) { return juce::String(value, 1) + " dB"; },
+                                                   [](const juce::String& text) { return text.getFloatValue(); })})
 {
     depthLeftParam      = parameters.getRawParameterValue("dpL");
     peakTimeLeftParam   = parameters.getRawParameterValue("ptL");
@@ -77,10 +234,69 @@ parameters(*this, nullptr, juce::Identifier ("wavesPlugin"),
     secondFuncRightParam = parameters.getRawParameterValue("sfR");
 
     monoStereoSwitchParam = parameters.getRawParameterValue("ms");
+    stereoOffsetParam     = parameters.getRawParameterValue("sof");
+
+    audioRateParam = parameters.getRawParameterValue("ar");
+    oversamplingParam = parameters.getRawParameterValue("os");
+    controlRateParam  = parameters.getRawParameterValue("ctl");
+    compactTablesParam = parameters.getRawParameterValue("cmp");
+
+    customShapeLeftParam  = parameters.getRawParameterValue("cuL");
+    customShapeRightParam = parameters.getRawParameterValue("cuR");
+
+    midiRetriggerParam = parameters.getRawParameterValue("mrt");
+    midiSpeedParam     = parameters.getRawParameterValue("msp");
+
+    sidechainTriggerParam   = parameters.getRawParameterValue("sc");
+    sidechainThresholdParam = parameters.getRawParameterValue("scT");
+
+    syncGroupParam = parameters.getRawParameterValue("grp");
+
+    dynamicParam          = parameters.getRawParameterValue("dyn");
+    dynamicThresholdParam = parameters.getRawParameterValue("dyT");
+    dynamicAttackParam    = parameters.getRawParameterValue("dyA");
+    dynamicReleaseParam   = parameters.getRawParameterValue("dyR");
+
+    randomParam     = parameters.getRawParameterValue("rnd");
+    randomSeedParam = parameters.getRawParameterValue("sed");
+
+    lfoOnParam = parameters.getRawParameterValue("lfo");
+    for (int i = 0; i < numModulationLfos; i++)
+    {
+        const auto lfo = "l" + juce::String(i + 1);
+        lfoRateParams[i]  = parameters.getRawParameterValue(lfo + "r");
+        lfoDepthParams[i] = parameters.getRawParameterValue(lfo + "d");
+        lfoSpeedParams[i] = parameters.getRawParameterValue(lfo + "s");
+    }
+
+    morphOnParam = parameters.getRawParameterValue("mon");
+    morphParam   = parameters.getRawParameterValue("mph");
+
+    numBandsParam = parameters.getRawParameterValue("bnd");
+    for (int i = 0; i < 3; i++)
+    {
+        const auto band = juce::String(i + 2);
+        crossoverParams[i]      = parameters.getRawParameterValue("xo" + juce::String(i + 1));
+        depthBandParams[i]      = parameters.getRawParameterValue("dpB" + band);
+        peakTimeBandParams[i]   = parameters.getRawParameterValue("ptB" + band);
+        speedBandParams[i]      = parameters.getRawParameterValue("spB" + band);
+        firstFuncBandParams[i]  = parameters.getRawParameterValue("ffB" + band);
+        secondFuncBandParams[i] = parameters.getRawParameterValue("sfB" + band);
+    }
+
+    loadCustomShape();
+    loadMorphSnapshots();
+
+   #if WAVES_TRACING
+    TraceRecorder::getInstance(); // so its buffers aren't allocated by the first span on the audio thread
+   #endif
+
+    tableBuilder.start();
 }
 
 WavesAudioProcessor::~WavesAudioProcessor()
 {
+    tableBuilder.stop(); // before the waves it builds for go
 }
 
 //==============================================================================
@@ -151,7 +367,89 @@ void WavesAudioProcessor::prepareToPlay (double sampleRate, int samplesPerBlock)
     // Use this method as the place to do any pre-playback
     // initialisation that you need..
 
-    myWaves.resize(getTotalNumOutputChannels()); // one waves object per output channel (hoping output is the right one to use)
+    mSampleRate = (float)sampleRate;
+    midiClockTicks = 0;
+    samplesProcessed = 0;
+
+    // both factors for both precisions, so switching never allocates on the audio thread
+    maxBlockSize = samplesPerBlock;
+
+   #if WAVES_TRACING
+    if (traceBuffer < 0)
+        traceBuffer = TraceRecorder::getInstance().claimBuffer("audio thread");
+   #endif
+
+    auto& oversamplers       = processingState.oversamplers;
+    auto& oversamplersDouble = processingStateDouble.oversamplers;
+
+    for (size_t i = 0; i < oversamplers.size(); i++)
+    {
+        oversamplers[i] = std::make_unique<juce::dsp::Oversampling<float>>(2, i + 1, juce::dsp::Oversampling<float>::filterHalfBandPolyphaseIIR, false, true);
+        oversamplers[i]->initProcessing((size_t) samplesPerBlock);
+
+        oversamplersDouble[i] = std::make_unique<juce::dsp::Oversampling<double>>(2, i + 1, juce::dsp::Oversampling<double>::filterHalfBandPolyphaseIIR, false, true);
+        oversamplersDouble[i]->initProcessing((size_t) samplesPerBlock);
+    }
+
+    // the crossover runs at the oversampled rate, so each factor has its own prepared at its rate
+    // and changing the factor in a block only picks another one
+    for (size_t i = 0; i < processingState.crossovers.size(); i++)
+    {
+        const juce::dsp::ProcessSpec crossoverSpec { sampleRate * (double) (1 << i), (juce::uint32) samplesPerBlock << i, 2 };
+        processingState.crossovers[i].prepare(crossoverSpec);
+        processingStateDouble.crossovers[i].prepare(crossoverSpec);
+    }
+
+    // the waves are prepared for the highest rate, so their tables have room for a cycle at any factor,
+    // and the dynamic mode follows the level at the oversampled rate too, so it is sized the same way
+    const juce::dsp::ProcessSpec highestSpec { sampleRate * 4.0, (juce::uint32) samplesPerBlock * 4, 2 };
+    for (auto& wave : myWaves)
+        wave.prepare(highestSpec);
+    for (auto& wave : myWavesDouble)
+        wave.prepare(highestSpec);
+
+    processingState.levelFollower.prepare(highestSpec);
+    processingStateDouble.levelFollower.prepare(highestSpec);
+    processingState.curveBuffer.setSize(2, samplesPerBlock * 4);
+    processingStateDouble.curveBuffer.setSize(2, samplesPerBlock * 4);
+
+    // the curve is delayed like the audio, by up to the longer of the two oversamplers' latencies
+    const auto longestLatency = juce::roundToInt (juce::jmax (oversamplers[0]->getLatencyInSamples(),
+                                                              oversamplers[1]->getLatencyInSamples()));
+    processingState.curveDelayLine.setSize(2, longestLatency + 1);
+    processingStateDouble.curveDelayLine.setSize(2, longestLatency + 1);
+    processingState.curveDelay = processingStateDouble.curveDelay = -1;
+
+    // the waves and the crossover start out at the rate of the current oversampling setting,
+    // so the first block doesn't have to change anything
+    oversamplingChoice = juce::jlimit(0, 2, juce::roundToInt(oversamplingParam->load()));
+    oversamplingFactor = 1 << oversamplingChoice;
+    setRateForFactor(myWaves, processingState, oversamplingFactor);
+    setRateForFactor(myWavesDouble, processingStateDouble, oversamplingFactor);
+
+    cancelPendingUpdate();
+    oversamplingLatency = oversamplingChoice > 0 ? juce::roundToInt (oversamplers[(size_t) oversamplingChoice - 1]->getLatencyInSamples()) : 0;
+    setLatencySamples (oversamplingLatency.load());
+
+    // every playback, and so every offline bounce, starts each wave from the top of its cycle
+    // and the random variations from the seed
+    for (auto& wave : myWaves)
+        wave.reset();
+    for (auto& wave : myWavesDouble)
+        wave.reset();
+
+    randomSeed = juce::roundToInt(randomSeedParam->load());
+    seedWaves(myWaves);
+    seedWaves(myWavesDouble);
+
+    for (auto& lfo : modulationLfos)
+        lfo.reset();
+    samplesToModulation = 0;
+
+    const juce::dsp::ProcessSpec sidechainSpec { sampleRate, (juce::uint32) samplesPerBlock,
+                                                 (juce::uint32) getChannelCountOfBus(true, 1) };
+    processingState.sidechainDetector.prepare(sidechainSpec);
+    processingStateDouble.sidechainDetector.prepare(sidechainSpec);
 }
 
 void WavesAudioProcessor::releaseResources()
@@ -179,6 +477,26 @@ bool WavesAudioProcessor::isBusesLayoutSupported (const BusesLayout& layouts) co
    #if ! JucePlugin_IsSynth
     if (layouts.getMainOutputChannelSet() != layouts.getMainInputChannelSet())
         return false;
+
+    // the sidechain can be switched off, or be mono or stereo
+    if (layouts.inputBuses.size() > 1)
+    {
+        const auto sidechain = layouts.getChannelSet(true, 1);
+        if (! sidechain.isDisabled()
+         && sidechain != juce::AudioChannelSet::mono()
+         && sidechain != juce::AudioChannelSet::stereo())
+            return false;
+    }
+
+    // and so can the modulation output
+    if (layouts.outputBuses.size() > 1)
+    {
+        const auto modulation = layouts.getChannelSet(false, 1);
+        if (! modulation.isDisabled()
+         && modulation != juce::AudioChannelSet::mono()
+         && modulation != juce::AudioChannelSet::stereo())
+            return false;
+    }
    #endif
 
     return true;
@@ -186,59 +504,674 @@ bool WavesAudioProcessor::isBusesLayoutSupported (const BusesLayout& layouts) co
 }
 #endif
 
+bool WavesAudioProcessor::supportsDoublePrecisionProcessing() const
+{
+    return true;
+}
+
 void WavesAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages)
+{
+    WAVES_TRACE_SCOPE_IN(traceBuffer, "processBlock");
+    processSamples(buffer, midiMessages, myWaves, processingState);
+}
+
+void WavesAudioProcessor::processBlock (juce::AudioBuffer<double>& buffer, juce::MidiBuffer& midiMessages)
+{
+    WAVES_TRACE_SCOPE_IN(traceBuffer, "processBlock");
+    processSamples(buffer, midiMessages, myWavesDouble, processingStateDouble);
+}
+
+void WavesAudioProcessor::processBlockBypassed (juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages)
+{
+    WAVES_TRACE_SCOPE_IN(traceBuffer, "processBlockBypassed");
+    bypassSamples(buffer, myWaves, processingState);
+}
+
+void WavesAudioProcessor::processBlockBypassed (juce::AudioBuffer<double>& buffer, juce::MidiBuffer& midiMessages)
+{
+    WAVES_TRACE_SCOPE_IN(traceBuffer, "processBlockBypassed");
+    bypassSamples(buffer, myWavesDouble, processingStateDouble);
+}
+
+template <typename SampleType>
+void WavesAudioProcessor::bypassSamples (juce::AudioBuffer<SampleType>& buffer, std::vector<Waves<SampleType>>& waves,
+                                         ProcessingState<SampleType>& state)
+{
+    // the audio passes through untouched, but the waves keep moving so they are in sync when un-bypassed
+    midiClockTicks = 0; // clock ticks aren't counted while bypassed
+    updateParameters(waves);
+    auto* oversampler = updateOversampling(waves, state);
+
+    updateTables(waves);
+    syncToGroup(waves, buffer.getNumSamples());
+
+    // the LFOs keep moving too, ramping across the whole block
+    if (isModulating())
+        modulateWaves(waves, buffer.getNumSamples());
+    samplesToModulation = 0;
+
+    for (auto& wave : waves)
+        wave.advance(buffer.getNumSamples() * oversamplingFactor);
+
+    // the audio isn't being changed, so the curve stays at unity
+    if (isWritingCurve())
+    {
+        auto modulationBus = getBusBuffer(buffer, false, 1);
+        for (int channel = 0; channel < modulationBus.getNumChannels(); channel++)
+            juce::FloatVectorOperations::fill(modulationBus.getWritePointer(channel), SampleType(1), modulationBus.getNumSamples());
+    }
+
+    // going through the oversampling filters keeps the latency the same as when processing
+    if (oversampler != nullptr)
+    {
+        juce::dsp::AudioBlock<SampleType> block (buffer.getArrayOfWritePointers(),
+                                                 (size_t) getMainBusNumInputChannels(), (size_t) buffer.getNumSamples());
+        oversampler->processSamplesUp (block);
+        oversampler->processSamplesDown (block);
+    }
+}
+
+template <typename SampleType>
+void WavesAudioProcessor::setRateForFactor (std::vector<Waves<SampleType>>& waves, ProcessingState<SampleType>& state, int factor)
+{
+    // everything after the oversampler runs at the oversampled rate, the phase of
+    // the waves carries over as their new tables arrive
+    const auto rate = (double) mSampleRate * factor;
+
+    for (auto& wave : waves)
+        wave.setSampleRate(rate);
+
+    state.levelFollower.setSampleRate(rate);
+}
+
+void WavesAudioProcessor::handleAsyncUpdate()
+{
+    setLatencySamples (oversamplingLatency.load());
+}
+
+template <typename SampleType>
+juce::dsp::Oversampling<SampleType>* WavesAudioProcessor::updateOversampling (std::vector<Waves<SampleType>>& waves,
+                                                                              ProcessingState<SampleType>& state)
+{
+    auto& oversamplersToUse = state.oversamplers;
+
+    auto choice = juce::jlimit(0, 2, juce::roundToInt(oversamplingParam->load()));
+    if (oversamplersToUse[0] == nullptr)
+        choice = 0; // not prepared yet
+
+    auto* oversampler = choice > 0 ? oversamplersToUse[(size_t) choice - 1].get() : nullptr;
+    const auto factor = 1 << choice;
+
+    // only picks up what prepareToPlay made ready, the host hears about the new latency from the message thread
+    if (factor != oversamplingFactor)
+    {
+        oversamplingChoice = choice;
+        oversamplingFactor = factor;
+
+        setRateForFactor(waves, state, factor);
+        state.crossovers[(size_t) choice].reset();
+
+        if (oversampler != nullptr)
+            oversampler->reset();
+
+        oversamplingLatency = oversampler != nullptr ? juce::roundToInt (oversampler->getLatencyInSamples()) : 0;
+        triggerAsyncUpdate();
+    }
+
+    return oversampler;
+}
+
+template <typename SampleType>
+void WavesAudioProcessor::updateParameters (std::vector<Waves<SampleType>>& waves)
+{
+    // the speed dials are overridden once MIDI has set a speed
+    const bool useMidiSpeed = juce::roundToInt(midiSpeedParam->load()) != midiSpeedOff && midiSpeed > 0.0f;
+    auto speed = [&](float dial) { return useMidiSpeed ? midiSpeed : dial; };
+
+    // audio rate waves are read from band-limited tables so they stay in tune and don't alias
+    const bool audioRate = juce::roundToInt(audioRateParam->load()) == 1;
+
+    // the LFOs scale the depth and speed of every wave as it is read, so modulation never rebuilds a table
+    const bool modulating = isModulating();
+    if (! modulating)
+        for (auto& wave : waves)
+            wave.clearModulation();
+
+    // morphing reads snapshot A through the first two waves and snapshot B through the morph targets,
+    // all band-limited so the amount can move without any table being rebuilt
+    const bool morphing = juce::roundToInt(morphOnParam->load()) == 1;
+
+    // in mono the right channel reads the left channel's waves, so its own are left as they are
+    const int numChannels = channelsShareWaves() ? 1 : 2;
+
+    if (morphing)
+    {
+        for (int channel = 0; channel < numChannels; channel++)
+        {
+            for (int slot = 0; slot < 2; slot++)
+            {
+                const auto& snapshot = morphSnapshots[(size_t) slot][(size_t) channel];
+                setWave(waves[(size_t) (slot == 0 ? channel : morphTargetIndex + channel)],
+                        snapshot[morphDepth].load(), speed(snapshot[morphSpeed].load()), snapshot[morphPeakTime].load(),
+                        juce::roundToInt(snapshot[morphFirstFunction].load()), juce::roundToInt(snapshot[morphSecondFunction].load()),
+                        juce::roundToInt(snapshot[morphCustomShape].load()) == 1, true);
+            }
+
+            waves[(size_t) channel].setMorph(&waves[(size_t) (morphTargetIndex + channel)], (SampleType) morphParam->load());
+        }
+    }
+    else
+    {
+        // set all parameters, the tables are only regenerated if these have changed
+        waves[0].setMorph(nullptr, 0);
+        setWave(waves[0], depthLeftParam->load(), speed(speedLeftParam->load()), peakTimeLeftParam->load(),
+                juce::roundToInt(firstFuncLeftParam->load()), juce::roundToInt(secondFuncLeftParam->load()),
+                juce::roundToInt(customShapeLeftParam->load()) == 1, audioRate);
+
+        if (numChannels == 2)
+        {
+            waves[1].setMorph(nullptr, 0);
+            setWave(waves[1], depthRightParam->load(), speed(speedRightParam->load()), peakTimeRightParam->load(),
+                    juce::roundToInt(firstFuncRightParam->load()), juce::roundToInt(secondFuncRightParam->load()),
+                    juce::roundToInt(customShapeRightParam->load()) == 1, audioRate);
+        }
+    }
+
+    // bands 2 to 4, both channels of a band follow the same dials
+    for (int i = 0; i < 3; i++)
+        for (int channel = 0; channel < numChannels; channel++)
+            setWave(waves[(size_t) (2 * (i + 1) + channel)], depthBandParams[i]->load(), speed(speedBandParams[i]->load()),
+                    peakTimeBandParams[i]->load(), juce::roundToInt(firstFuncBandParams[i]->load()),
+                    juce::roundToInt(secondFuncBandParams[i]->load()), false, audioRate);
+}
+
+template <typename SampleType>
+void WavesAudioProcessor::setWave (Waves<SampleType>& wave, float depthDecibels, float speed, float peakTime,
+                                   int firstFunction, int secondFunction, bool customShape, bool bandLimited)
+{
+    // convert decibels to amplitude
+    const auto decibels = (SampleType) depthDecibels;
+    const auto depth    = sgn(depthDecibels) * (SampleType(1) - std::pow(SampleType(10), -std::abs(decibels) / SampleType(20)));
+
+    // convert speed into time, at audio rate the speed is in Hz rather than bpm
+    const SampleType secondsPerUnit = juce::roundToInt(audioRateParam->load()) == 1 ? 1 : 60;
+    const auto totalTime = secondsPerUnit / (SampleType) speed;
+
+    wave.setBandLimited(bandLimited);
+    wave.setControlRate(juce::roundToInt(controlRateParam->load()) == 1);
+    wave.setCompactStorage(juce::roundToInt(compactTablesParam->load()) == 1);
+    wave.setRandomisation((SampleType) randomParam->load());
+    wave.setParameters(depth, totalTime, (SampleType) peakTime * totalTime);
+    wave.setFunctions(firstFunction, secondFunction);
+    wave.setCustomShape(customShape, customShapeVersion.load());
+}
+
+template <typename SampleType>
+void WavesAudioProcessor::seedWaves (std::vector<Waves<SampleType>>& waves)
+{
+    // each wave gets its own stream, except that in mono both channels share one so they stay the same
+    const bool mono = juce::roundToInt(monoStereoSwitchParam->load()) == 0;
+
+    for (size_t i = 0; i < waves.size(); i++)
+    {
+        const auto stream = mono ? i / 2 : i;
+        waves[i].setRandomSeed((std::uint64_t) randomSeed * numWaves + stream);
+    }
+}
+
+bool WavesAudioProcessor::isModulating() const noexcept
+{
+    return juce::roundToInt(lfoOnParam->load()) == 1;
+}
+
+template <typename SampleType>
+void WavesAudioProcessor::modulateWaves (std::vector<Waves<SampleType>>& waves, int numSamples)
+{
+    // the LFOs are read at the end of the span, and the main waves ramp to them across it
+    float depthAmount = 0.0f, speedOctaves = 0.0f;
+
+    for (int i = 0; i < numModulationLfos; i++)
+    {
+        auto& lfo = modulationLfos[(size_t) i];
+        lfo.setRate(lfoRateParams[i]->load(), mSampleRate);
+
+        const auto value = lfo.advance(numSamples);
+        depthAmount  += value * lfoDepthParams[i]->load();
+        speedOctaves += value * lfoSpeedParams[i]->load();
+    }
+
+    const auto depthScale = (SampleType) juce::jlimit(0.0f, 2.0f, 1.0f + depthAmount);
+    const auto speedScale = std::exp2((double) speedOctaves);
+
+    for (auto& wave : waves)
+        wave.setModulation(depthScale, speedScale, numSamples * oversamplingFactor);
+}
+
+template <typename SampleType>
+void WavesAudioProcessor::updateTables (std::vector<Waves<SampleType>>& waves)
+{
+    // sends any changes to the table builder and picks up the tables it has finished,
+    // the unused bands keep theirs up to date too so switching bands is instant
+    bool needsBuild = false;
+    for (auto& wave : waves)
+        needsBuild = wave.updateTable() || needsBuild;
+
+    if (! needsBuild)
+        return;
+
+    tableBuilder.requestBuild();
+
+    // offline the audio thread can wait, so the new tables start at the same sample on every bounce
+    if (! isNonRealtime())
+        return;
+
+    tableBuilder.waitForBuild();
+
+    // a reseeded wave starts over on its seed's first table as soon as it has it, and then asks for
+    // the next cycle's, which is waited for too
+    needsBuild = false;
+    for (auto& wave : waves)
+        needsBuild = wave.updateTable() || needsBuild;
+
+    if (needsBuild)
+    {
+        tableBuilder.requestBuild();
+        tableBuilder.waitForBuild();
+    }
+}
+
+template <typename SampleType>
+bool WavesAudioProcessor::syncToGroup (std::vector<Waves<SampleType>>& waves, int numSamples)
+{
+    const auto group = juce::roundToInt(syncGroupParam->load());
+    if (group == 0)
+        return false;
+
+    // the clock counts host samples, the waves may be running oversampled. The morph targets are
+    // read at their main wave's phase, so moving the morph bends the main wave's cycle and they
+    // have no position of their own to set
+    const auto position = SharedClock::getInstance().beginBlock(group, clockMember, numSamples);
+    for (int index = 0; index < morphTargetIndex; index++)
+        waves[(size_t) index].setPosition(position * oversamplingFactor);
+
+    return true;
+}
+
+template <typename SampleType>
+void WavesAudioProcessor::updateCrossover (Crossover<SampleType>& crossover)
+{
+    crossover.setNumBands(juce::roundToInt(numBandsParam->load()));
+    crossover.setFrequencies((SampleType) crossoverParams[0]->load(),
+                             (SampleType) crossoverParams[1]->load(),
+                             (SampleType) crossoverParams[2]->load());
+}
+
+template <typename SampleType>
+void WavesAudioProcessor::processSamples (juce::AudioBuffer<SampleType>& buffer, juce::MidiBuffer& midiMessages,
+                                          std::vector<Waves<SampleType>>& waves, ProcessingState<SampleType>& state)
 {
     juce::ScopedNoDenormals noDenormals;
-    auto totalNumInputChannels  = getTotalNumInputChannels();
-    auto totalNumOutputChannels = getTotalNumOutputChannels();
+    auto totalNumInputChannels  = getMainBusNumInputChannels(); // the sidechain channels come after these
+    auto totalNumOutputChannels = getMainBusNumOutputChannels();
+    const auto numSamples       = buffer.getNumSamples();
 
     for (auto i = totalNumInputChannels; i < totalNumOutputChannels; ++i)
-        buffer.clear (i, 0, buffer.getNumSamples());
+        buffer.clear (i, 0, numSamples);
 
-    // get values from the parameters valueTreeState
-    auto depthLeft           = depthLeftParam->load();
-    const auto speedLeft     = speedLeftParam->load();
-    const auto peakTimeLeft  = peakTimeLeftParam->load();
+    if (juce::roundToInt(randomSeedParam->load()) != randomSeed)
+    {
+        randomSeed = juce::roundToInt(randomSeedParam->load());
+        seedWaves(waves);
+    }
+
+    updateParameters(waves);
+    auto* oversampler = updateOversampling(waves, state);
 
-    const auto firstFuncLeft  = juce::roundToInt (firstFuncLeftParam->load());
-    const auto secondFuncLeft = juce::roundToInt (secondFuncLeftParam->load());
+    auto& crossover = state.crossovers[(size_t) oversamplingChoice];
+    updateCrossover(crossover);
+    const auto numBands = crossover.getNumBands();
 
-    auto depthRight           = depthRightParam->load();
-    const auto speedRight     = speedRightParam->load();
-    const auto peakTimeRight  = peakTimeRightParam->load();
+    // find the sidechain hits that restart the waves
+    int numTriggers = 0;
+    if (juce::roundToInt(sidechainTriggerParam->load()) == 1 && getChannelCountOfBus(true, 1) > 0)
+    {
+        auto sidechain = getBusBuffer(buffer, true, 1);
+        state.sidechainDetector.setThreshold((SampleType)sidechainThresholdParam->load());
+        numTriggers = state.sidechainDetector.process(sidechain.getArrayOfReadPointers(), sidechain.getNumChannels(), numSamples);
+    }
+    const auto* triggers = state.sidechainDetector.getTriggerOffsets();
 
-    const auto firstFuncRight  = juce::roundToInt(firstFuncRightParam->load());
-    const auto secondFuncRight = juce::roundToInt(secondFuncRightParam->load());
+    jassert(totalNumInputChannels <= 2);
 
-    const auto monoStereoSwitch = juce::roundToInt(monoStereoSwitchParam->load());
+    // in mono both channels of a stereo pair are read from the left channel's wave, the right one
+    // the offset further into the cycle, so there is only one table to build for each band
+    const bool sharedWaves  = channelsShareWaves() && totalNumInputChannels == 2;
+    const auto stereoOffset = (double) stereoOffsetParam->load() / 360.0;
+    auto getWave = [&](int band, int channel) -> Waves<SampleType>& { return waves[2 * band + (sharedWaves ? 0 : channel)]; };
 
-    // convert decibels to amplitude
-    depthLeft  = sgn(depthLeft) * (1.0f - std::pow(10.0f, -std::abs(depthLeft) / 20.0f));
-    depthRight = sgn(depthRight) * (1.0f - std::pow(10.0f, -std::abs(depthRight) / 20.0f));
-
-    // convert speed into time:
-    const auto totalTimeLeft  = 60.0f / speedLeft;
-    const auto totalTimeRight = 60.0f / speedRight;
-
-    // set all parameters
-    myWaves[0].setParameters(depthLeft, totalTimeLeft, peakTimeLeft * totalTimeLeft);
-    myWaves[0].updateFunctions(firstFuncLeft, secondFuncLeft);
-    myWaves[1].setParameters(depthRight, totalTimeRight, peakTimeRight * totalTimeRight);
-    myWaves[1].updateFunctions(firstFuncRight, secondFuncRight);
-
-    // loop over channels
-    for (int channel = 0; channel < totalNumInputChannels; channel++)
-    {
-        auto* channelData = buffer.getWritePointer(channel);
-        
-        // loop over the samples in this buffer
-        for (int sample = 0; sample < buffer.getNumSamples(); sample++)
+    updateTables(waves);
+
+    // in a sync group the shared clock sets the phase, and local restarts are left out so the group stays locked
+    const bool synced = syncToGroup(waves, numSamples);
+
+    // the gain curve of the main waves goes out of the modulation bus when the host has switched it on,
+    // it is written from the gains as they are multiplied, so even silent blocks have to go through them
+    const bool writeCurve = isWritingCurve();
+
+    // the gain stage runs on the oversampled signal when oversampling is on
+    juce::dsp::AudioBlock<SampleType> block (buffer.getArrayOfWritePointers(), (size_t) totalNumInputChannels, (size_t) numSamples);
+    auto gainBlock = oversampler != nullptr ? oversampler->processSamplesUp (block) : block;
+    const auto factor = oversamplingFactor;
+
+    // in the dynamic mode the tremolo follows the input level, the waves scale their dips by it at each sample
+    const auto* dynamicAmounts = followLevel (gainBlock, state);
+
+    // in multiband mode each band gets its own waves and the bands are summed afterwards
+    if (numBands > 1)
+        crossover.split (gainBlock);
+
+    auto getSamples = [&](int band, int channel)
+    {
+        return numBands > 1 ? crossover.getBand(band, channel) : gainBlock.getChannelPointer((size_t) channel);
+    };
+
+    // a flat wave or a silent block would come out unchanged, so skip the multiply and just keep the
+    // phase moving. Silence is looked for in what each wave multiplies, as the oversampling filters
+    // and the crossover both ring on for a while after the input stops
+    bool unchanged[2 * Crossover<SampleType>::maxBands];
+
+    auto isSilent = [&](const SampleType* samples)
+    {
+        const auto range = juce::FloatVectorOperations::findMinAndMax (samples, (int) gainBlock.getNumSamples());
+        return range.getStart() == SampleType (0) && range.getEnd() == SampleType (0);
+    };
+
+    for (int band = 0; band < numBands; band++)
+        for (int channel = 0; channel < totalNumInputChannels; channel++)
+            unchanged[2 * band + channel] = getWave(band, channel).isUnity()
+                                         || (! writeCurve && isSilent (getSamples (band, channel)));
+
+    int start = 0;
+    auto getCurve = [&](int channel) { return state.curveBuffer.getWritePointer(channel) + start * factor; };
+    auto getAmounts = [&]() { return dynamicAmounts != nullptr ? dynamicAmounts + start * factor : nullptr; };
+
+    // the block is split at every sidechain trigger and MIDI event, and each
+    // span is multiplied by the waves in contiguous runs
+    auto renderSpan = [&](int end)
+    {
+        const auto spanLength = (end - start) * factor;
+
+        for (int band = 0; band < numBands; band++)
         {
-            auto volumeMultiplier = myWaves[channel].getNext(); // should get these once per buffer probably
-            channelData[sample] = buffer.getSample(channel, sample) * volumeMultiplier;
+            // only the first band's waves are in the curve
+            const bool curveBand = writeCurve && band == 0;
+
+            if (sharedWaves)
+            {
+                auto& wave = waves[2 * band];
+
+                if (unchanged[2 * band] && unchanged[2 * band + 1])
+                {
+                    wave.advance(spanLength);
+
+                    if (curveBand)
+                        for (int channel = 0; channel < 2; channel++)
+                            juce::FloatVectorOperations::fill(getCurve(channel), SampleType(1), spanLength);
+                }
+                else
+                {
+                    wave.processStereo(getSamples(band, 0) + start * factor, getSamples(band, 1) + start * factor,
+                                       spanLength, stereoOffset,
+                                       curveBand ? getCurve(0) : nullptr, curveBand ? getCurve(1) : nullptr,
+                                       getAmounts());
+                }
+                continue;
+            }
+
+            for (int channel = 0; channel < totalNumInputChannels; channel++)
+            {
+                auto& wave = waves[2 * band + channel];
+
+                if (unchanged[2 * band + channel])
+                {
+                    wave.advance(spanLength);
+
+                    if (curveBand)
+                        juce::FloatVectorOperations::fill(getCurve(channel), SampleType(1), spanLength);
+                }
+                else
+                {
+                    wave.process(getSamples(band, channel) + start * factor, spanLength,
+                                 curveBand ? getCurve(channel) : nullptr, getAmounts());
+                }
+            }
+        }
+
+        start = end;
+    };
+
+    // while modulating, the spans are also split every modulationInterval samples, where the LFOs are read
+    const bool modulating = isModulating();
+    auto renderUpTo = [&](int end)
+    {
+        while (start < end)
+        {
+            if (! modulating)
+            {
+                renderSpan(end);
+                break;
+            }
+
+            if (samplesToModulation == 0)
+            {
+                modulateWaves(waves, modulationInterval);
+                samplesToModulation = modulationInterval;
+            }
+
+            const auto spanEnd = juce::jmin(end, start + samplesToModulation);
+            samplesToModulation -= spanEnd - start;
+            renderSpan(spanEnd);
+        }
+    };
+
+    auto restartWaves = [&waves, synced]
+    {
+        if (synced)
+            return;
+
+        for (auto& wave : waves)
+            wave.reset();
+    };
+
+    int trigger = 0;
+    for (const auto metadata : midiMessages)
+    {
+        const auto offset = juce::jlimit(start, numSamples, metadata.samplePosition);
+
+        for (; trigger < numTriggers && triggers[trigger] <= offset; trigger++)
+        {
+            renderUpTo(triggers[trigger]);
+            restartWaves();
+        }
+
+        const auto event = handleMidiMessage(metadata.getMessage(), samplesProcessed + offset);
+        if (event == midiNothing)
+            continue;
+
+        renderUpTo(offset);
+
+        if (event & midiRetrigger)
+            restartWaves();
+
+        // the tables playing are stretched to the new speed from here until the builder has the new ones
+        if (event & midiSpeedChanged)
+        {
+            updateParameters(waves);
+            updateTables(waves);
+
+            for (auto& wave : waves)
+                wave.stretchToPeriod();
         }
     }
-   
+
+    for (; trigger < numTriggers; trigger++)
+    {
+        renderUpTo(triggers[trigger]);
+        restartWaves();
+    }
+
+    renderUpTo(numSamples);
+    samplesProcessed += numSamples;
+
+    if (numBands > 1)
+        crossover.sum (gainBlock);
+
+    if (oversampler != nullptr)
+        oversampler->processSamplesDown (block);
+
+    if (writeCurve)
+        writeCurveBus (buffer, state, totalNumInputChannels);
+}
+
+bool WavesAudioProcessor::isWritingCurve() const
+{
+    return getBusCount (false) > 1 && getChannelCountOfBus (false, 1) > 0;
+}
+
+template <typename SampleType>
+void WavesAudioProcessor::writeCurveBus (juce::AudioBuffer<SampleType>& buffer, ProcessingState<SampleType>& state,
+                                         int numCurveChannels)
+{
+    // the modulation bus shares its channels with the sidechain, which has been read by now
+    auto modulationBus = getBusBuffer (buffer, false, 1);
+    const auto& curves = state.curveBuffer;
+    const auto factor  = oversamplingFactor;
+
+    for (int channel = 0; channel < modulationBus.getNumChannels(); channel++)
+    {
+        const auto* curve = curves.getReadPointer (juce::jmin (channel, numCurveChannels - 1));
+        auto* output = modulationBus.getWritePointer (channel);
+
+        // a tremolo curve has nothing near nyquist, so oversampled curves just take every factor-th gain
+        if (factor == 1)
+            juce::FloatVectorOperations::copy (output, curve, modulationBus.getNumSamples());
+        else
+            for (int i = 0; i < modulationBus.getNumSamples(); i++)
+                output[i] = curve[i * factor];
+    }
+
+    // the audio comes out of the oversampling filters late, so the curve is held back to line up with it,
+    // starting from unity whenever the latency changes
+    auto& delayLine = state.curveDelayLine;
+    const auto lineLength = delayLine.getNumSamples();
+    const auto delay = juce::jmin (getLatencySamples(), lineLength - 1);
+
+    if (delay != state.curveDelay)
+    {
+        for (int channel = 0; channel < delayLine.getNumChannels(); channel++)
+            juce::FloatVectorOperations::fill (delayLine.getWritePointer (channel), SampleType (1), lineLength);
+
+        state.curveDelay = delay;
+        state.curveDelayPosition = 0;
+    }
+
+    if (delay == 0)
+        return;
+
+    auto position = state.curveDelayPosition;
+    for (int channel = 0; channel < modulationBus.getNumChannels(); channel++)
+    {
+        auto* line   = delayLine.getWritePointer (channel);
+        auto* output = modulationBus.getWritePointer (channel);
+        position     = state.curveDelayPosition;
+
+        for (int i = 0; i < modulationBus.getNumSamples(); i++)
+        {
+            line[position] = output[i];
+            output[i] = line[position >= delay ? position - delay : position - delay + lineLength];
+            position  = position + 1 < lineLength ? position + 1 : 0;
+        }
+    }
+
+    state.curveDelayPosition = position;
+}
+
+template <typename SampleType>
+const SampleType* WavesAudioProcessor::followLevel (const juce::dsp::AudioBlock<SampleType>& gainBlock,
+                                                    ProcessingState<SampleType>& state)
+{
+    if (juce::roundToInt(dynamicParam->load()) != 1)
+        return nullptr;
+
+    const auto numChannels = (int) gainBlock.getNumChannels();
+    const auto numSamples  = (int) gainBlock.getNumSamples();
+
+    auto& follower = state.levelFollower;
+    follower.setThreshold((SampleType) dynamicThresholdParam->load());
+    follower.setTimes((SampleType) dynamicAttackParam->load(), (SampleType) dynamicReleaseParam->load());
+
+    const SampleType* channels[2] = {};
+    for (int channel = 0; channel < numChannels; channel++)
+        channels[channel] = gainBlock.getChannelPointer ((size_t) channel);
+
+    return follower.process (channels, numChannels, numSamples);
+}
+
+int WavesAudioProcessor::handleMidiMessage (const juce::MidiMessage& message, juce::int64 time)
+{
+    const auto speedSource = juce::roundToInt(midiSpeedParam->load());
+    int event = midiNothing;
+
+    if (message.isNoteOn())
+    {
+        if (juce::roundToInt(midiRetriggerParam->load()) == 1)
+            event |= midiRetrigger;
+
+        // middle C is the default 240 bpm, and each octave doubles or halves it
+        if (speedSource == midiSpeedFromNote)
+            event |= setMidiSpeed(240.0f * std::pow(2.0f, (message.getNoteNumber() - 60) / 12.0f));
+    }
+    else if (message.isController() && message.getControllerNumber() == 1)
+    {
+        if (speedSource == midiSpeedFromModWheel)
+            event |= setMidiSpeed(60.0f + 420.0f * message.getControllerValue() / 127.0f);
+    }
+    else if (message.isMidiStart())
+    {
+        midiClockTicks = 0;
+
+        if (juce::roundToInt(midiRetriggerParam->load()) == 1)
+            event |= midiRetrigger;
+    }
+    else if (message.isMidiClock() && speedSource == midiSpeedFromClock)
+    {
+        // 24 clock ticks to a beat, and one wave per beat
+        if (midiClockTicks == 24)
+        {
+            if (time > midiBeatStart)
+                event |= setMidiSpeed((float)(60.0 * mSampleRate / (double)(time - midiBeatStart)));
+            midiClockTicks = 0;
+        }
+
+        if (midiClockTicks == 0)
+            midiBeatStart = time;
+
+        midiClockTicks++;
+    }
+
+    return event;
+}
+
+int WavesAudioProcessor::setMidiSpeed (float newSpeed)
+{
+    newSpeed = juce::jlimit(60.0f, 480.0f, newSpeed);
+
+    // ignore jitter in the clock so the tables aren't rebuilt every beat
+    if (std::abs(newSpeed - midiSpeed) < 0.5f)
+        return midiNothing;
+
+    midiSpeed = newSpeed;
+    return midiSpeedChanged;
 }
 
 //==============================================================================
@@ -255,22 +1188,55 @@ juce::AudioProcessorEditor* WavesAudioProcessor::createEditor()
 //==============================================================================
 void WavesAudioProcessor::getStateInformation (juce::MemoryBlock& destData)
 {
-    // You should use this method to store your parameters in the memory block.
-    // You could do that either as raw data, or use the XML or ValueTree classes
-    // as intermediaries to make it easy to save and load complex data.
-    auto state = parameters.copyState();
-    std::unique_ptr<juce::XmlElement> xml (state.createXml());
-    copyXmlToBinary (*xml, destData);
+    // The state is written as a small header followed by the binary ValueTree,
+    // which avoids building and parsing XML for every instance on project save/load.
+    juce::MemoryOutputStream stream (destData, false);
+    stream.writeInt (stateMagicNumber);
+    stream.writeInt (stateVersion);
+    parameters.copyState().writeToStream (stream);
+
+    // the session is being saved, so put its tables in the cache for when it is opened again,
+    // unless they are already there from the last save
+    if (isTableCacheEnabled() && tablesChangedSinceStore)
+    {
+        storeTablesRequested = true;
+        tableBuilder.requestBuild();
+    }
 }
 
 void WavesAudioProcessor::setStateInformation (const void* data, int sizeInBytes)
 {
     // You should use this method to restore your parameters from this memory block,
     // whose contents will have been created by the getStateInformation() call.
+    juce::MemoryInputStream stream (data, (size_t) sizeInBytes, false);
+
+    if (sizeInBytes > 8 && stream.readInt() == stateMagicNumber)
+    {
+        if (stream.readInt() > stateVersion)
+            return; // saved by a newer version we don't know how to read
+
+        auto tree = juce::ValueTree::readFromStream (stream);
+        if (tree.hasType (parameters.state.getType()))
+        {
+            parameters.replaceState (tree);
+            loadCustomShape();
+            loadMorphSnapshots();
+            tableCacheEnabled = isTableCacheEnabled();
+        }
+
+        return;
+    }
+
+    // states saved before the binary format were written as XML
     std::unique_ptr<juce::XmlElement> xmlState (getXmlFromBinary (data, sizeInBytes));
     if (xmlState.get() != nullptr)
         if (xmlState->hasTagName (parameters.state.getType()))
+        {
             parameters.replaceState (juce::ValueTree::fromXml (*xmlState));
+            loadCustomShape();
+            loadMorphSnapshots();
+            tableCacheEnabled = isTableCacheEnabled();
+        }
 }
 
 //==============================================================================
@@ -282,6 +1248,158 @@ juce::AudioProcessor* JUCE_CALLTYPE createPluginFilter()
 
 std::vector<float> WavesAudioProcessor::getFunctionValues(const int channel)
 {
+    WAVES_TRACE_SCOPE("getFunctionValues");
     jassert(channel == 0 || channel == 1);
-    return myWaves[channel].getWaveArray(); // TODO: error handling :)
+
+    // in mono the right channel plays the left channel's table
+    const auto index = channelsShareWaves() ? 0 : channel;
+
+    if (isUsingDoublePrecision())
+    {
+        const auto values = myWavesDouble[index].getDisplayTable();
+        return std::vector<float>(values.begin(), values.end());
+    }
+
+    return myWaves[index].getDisplayTable();
+}
+
+//==============================================================================
+namespace
+{
+    const juce::Identifier customShapeId ("CustomShape");
+    const juce::Identifier pointId ("Point");
+    const juce::Identifier xId ("x");
+    const juce::Identifier yId ("y");
+    const juce::Identifier tableCacheId ("tableCache");
+
+    const juce::Identifier morphSnapshotIds[] = { "MorphA", "MorphB" };
+
+    // the dials stored in a snapshot, in MorphValue order, with L or R on the end
+    const char* const morphParameterIds[] = { "dp", "pt", "sp", "ff", "sf", "cu" };
+    const char* const channelSuffixes[]   = { "L", "R" };
+}
+
+void WavesAudioProcessor::setCustomShape (const std::vector<juce::Point<float>>& points)
+{
+    // the points live in the state tree so they are saved with the session
+    auto shapeTree = parameters.state.getOrCreateChildWithName (customShapeId, nullptr);
+    shapeTree.removeAllChildren (nullptr);
+
+    for (auto point : points)
+        shapeTree.appendChild (juce::ValueTree (pointId, { { xId, point.x }, { yId, point.y } }), nullptr);
+
+    loadCustomShape();
+}
+
+std::vector<juce::Point<float>> WavesAudioProcessor::getCustomShape() const
+{
+    const juce::SpinLock::ScopedLockType lock (customShapeLock);
+    return customShapePoints;
+}
+
+void WavesAudioProcessor::loadCustomShape()
+{
+    std::vector<juce::Point<float>> points;
+
+    auto shapeTree = parameters.state.getChildWithName (customShapeId);
+    if (shapeTree.isValid())
+    {
+        for (const auto& point : shapeTree)
+            points.push_back ({ (float) point[xId], (float) point[yId] });
+    }
+    else
+    {
+        points = CustomShape().getPoints();
+    }
+
+    {
+        const juce::SpinLock::ScopedLockType lock (customShapeLock);
+        customShapePoints = std::move (points);
+    }
+
+    // the audio thread sees the new version and asks for the custom tables to be rebuilt
+    customShapeVersion++;
+}
+
+void WavesAudioProcessor::storeMorphSnapshot (int slot)
+{
+    jassert(slot == 0 || slot == 1);
+    auto snapshotTree = parameters.state.getOrCreateChildWithName (morphSnapshotIds[slot], nullptr);
+
+    for (int channel = 0; channel < 2; channel++)
+    {
+        for (int value = 0; value < numMorphValues; value++)
+        {
+            const auto id = juce::String (morphParameterIds[value]) + channelSuffixes[channel];
+            const auto dial = parameters.getRawParameterValue (id)->load();
+
+            snapshotTree.setProperty (juce::Identifier (id), dial, nullptr);
+            morphSnapshots[(size_t) slot][(size_t) channel][(size_t) value] = dial;
+        }
+    }
+}
+
+void WavesAudioProcessor::loadMorphSnapshots()
+{
+    // a snapshot that was never stored takes the current dials
+    for (int slot = 0; slot < 2; slot++)
+    {
+        auto snapshotTree = parameters.state.getChildWithName (morphSnapshotIds[slot]);
+
+        for (int channel = 0; channel < 2; channel++)
+        {
+            for (int value = 0; value < numMorphValues; value++)
+            {
+                const auto id = juce::String (morphParameterIds[value]) + channelSuffixes[channel];
+                const float dial = snapshotTree.getProperty (juce::Identifier (id), parameters.getRawParameterValue (id)->load());
+                morphSnapshots[(size_t) slot][(size_t) channel][(size_t) value] = dial;
+            }
+        }
+    }
+}
+
+void WavesAudioProcessor::buildTables()
+{
+    // compile the newest custom shape here, never on the audio thread
+    const auto version = customShapeVersion.load();
+    if (version != builderShapeVersion)
+    {
+        builderShape.setPoints (getCustomShape());
+        builderShapeVersion = version;
+    }
+
+    auto* cache = tableCacheEnabled ? &tableCache : nullptr;
+
+    bool built = false;
+
+    for (auto& wave : myWaves)
+        built |= wave.buildTable (builderShape, cache);
+
+    for (auto& wave : myWavesDouble)
+        built |= wave.buildTable (builderShape, cache);
+
+    if (built)
+        tablesChangedSinceStore = true;
+
+    if (storeTablesRequested.exchange (false) && cache != nullptr)
+    {
+        tablesChangedSinceStore = false;
+
+        for (auto& wave : myWaves)
+            wave.storeTable (*cache);
+
+        for (auto& wave : myWavesDouble)
+            wave.storeTable (*cache);
+    }
+}
+
+void WavesAudioProcessor::setTableCacheEnabled (bool shouldCache)
+{
+    parameters.state.setProperty (tableCacheId, shouldCache, nullptr);
+    tableCacheEnabled = shouldCache;
+}
+
+bool WavesAudioProcessor::isTableCacheEnabled() const
+{
+    return parameters.state.getProperty (tableCacheId, true);
 }
\ No newline at end of file
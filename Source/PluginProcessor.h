@@ -10,12 +10,22 @@
 
 #include <JuceHeader.h>
 #include <algorithm>
+#include <array>
 #include <cmath>
+#include <memory>
 #include "Waves.h"
+#include "TransientDetector.h"
+#include "CustomShape.h"
+#include "WaveTableBuilder.h"
+#include "Crossover.h"
+#include "SharedClock.h"
+#include "ModulationLfo.h"
+#include "EnvelopeFollower.h"
 
 
 //==============================================================================
-class WavesAudioProcessor  : public juce::AudioProcessor
+class WavesAudioProcessor  : public juce::AudioProcessor,
+                             private juce::AsyncUpdater
 {
 public:
     //==============================================================================
@@ -31,6 +41,11 @@ public:
    #endif
 
     void processBlock (juce::AudioBuffer<float>&, juce::MidiBuffer&) override;
+    void processBlock (juce::AudioBuffer<double>&, juce::MidiBuffer&) override;
+    bool supportsDoublePrecisionProcessing() const override;
+
+    void processBlockBypassed (juce::AudioBuffer<float>&, juce::MidiBuffer&) override;
+    void processBlockBypassed (juce::AudioBuffer<double>&, juce::MidiBuffer&) override;
 
     //==============================================================================
     juce::AudioProcessorEditor* createEditor() override;
@@ -58,15 +73,38 @@ public:
     //==============================================================================
     std::vector<float> getFunctionValues(const int channel);
 
+    // the user-drawn shape, edited on the message thread and compiled by the table builder
+    void setCustomShape(const std::vector<juce::Point<float>>& points);
+    std::vector<juce::Point<float>> getCustomShape() const;
+
+    // copies the current dials of both channels into morph snapshot A (0) or B (1)
+    void storeMorphSnapshot(int slot);
+
+    // keeps the generated tables on disk when the session is saved, so they load faster next time
+    void setTableCacheEnabled(bool shouldCache);
+    bool isTableCacheEnabled() const;
+
     //==============================================================================   
     float mSampleRate = 1;
     int totalSamples = 1, peakSamples = 1; 
 
-    std::vector<Waves<float>> myWaves;
+    // one waves object per channel and band, the layouts are only ever mono or stereo,
+    // band 1 is [0] and [1], the multiband mode adds two more for each band and the
+    // last two hold the B side of the morph
+    static constexpr int morphTargetIndex = 2 * Crossover<float>::maxBands;
+    static constexpr int numWaves = morphTargetIndex + 2;
+
+    std::vector<Waves<float>> myWaves = std::vector<Waves<float>>(numWaves);
+    std::vector<Waves<double>> myWavesDouble = std::vector<Waves<double>>(numWaves); // used instead of myWaves when the host runs in 64-bit
 
 private:
     //==============================================================================
     juce::AudioProcessorValueTreeState parameters;
+
+    // header of the binary state written by getStateInformation
+    static constexpr int stateMagicNumber = 0x57617673; // "Wavs"
+    static constexpr int stateVersion     = 1;
+
     std::atomic<float>* depthLeftParam = nullptr;
     std::atomic<float>* peakTimeLeftParam = nullptr;
     std::atomic<float>* totalTimeLeftParam = nullptr;
@@ -83,6 +121,180 @@ private:
     std::atomic<float>* secondFuncRightParam = nullptr; // are retreived (processBlock)
 
     std::atomic<float>* monoStereoSwitchParam = nullptr;
+    std::atomic<float>* stereoOffsetParam = nullptr;
+
+    // in mono both channels play the left channel's waves, the right one offset by stereoOffsetParam
+    bool channelsShareWaves() const noexcept { return juce::roundToInt(monoStereoSwitchParam->load()) == 0; }
+
+    std::atomic<float>* audioRateParam = nullptr;
+    std::atomic<float>* oversamplingParam = nullptr;
+    std::atomic<float>* controlRateParam = nullptr;
+    std::atomic<float>* compactTablesParam = nullptr;
+
+    std::atomic<float>* customShapeLeftParam = nullptr;
+    std::atomic<float>* customShapeRightParam = nullptr;
+
+    std::atomic<float>* sidechainTriggerParam = nullptr;
+    std::atomic<float>* sidechainThresholdParam = nullptr;
+
+    std::atomic<float>* midiRetriggerParam = nullptr;
+    std::atomic<float>* midiSpeedParam = nullptr;
+
+    std::atomic<float>* syncGroupParam = nullptr;
+
+    // the dynamic mode, where the depth follows the input level
+    std::atomic<float>* dynamicParam = nullptr;
+    std::atomic<float>* dynamicThresholdParam = nullptr;
+    std::atomic<float>* dynamicAttackParam = nullptr;
+    std::atomic<float>* dynamicReleaseParam = nullptr;
+
+    std::atomic<float>* randomParam = nullptr;
+    std::atomic<float>* randomSeedParam = nullptr;
+    int randomSeed = 0;
+
+    // restarts the random variations of every wave from the seed
+    template <typename SampleType>
+    void seedWaves(std::vector<Waves<SampleType>>& waves);
+
+    // LFOs moving the depth and speed of every wave, read every modulationInterval samples
+    static constexpr int numModulationLfos  = 2;
+    static constexpr int modulationInterval = 32;
+    std::atomic<float>* lfoOnParam = nullptr;
+    std::array<std::atomic<float>*, numModulationLfos> lfoRateParams{}, lfoDepthParams{}, lfoSpeedParams{};
+    std::array<ModulationLfo, numModulationLfos> modulationLfos;
+    int samplesToModulation = 0;
+
+    bool isModulating() const noexcept;
+
+    // moves the LFOs on and sends where they are to the main waves, which ramp there over the span
+    template <typename SampleType>
+    void modulateWaves(std::vector<Waves<SampleType>>& waves, int numSamples);
+
+    std::atomic<float>* morphOnParam = nullptr;
+    std::atomic<float>* morphParam = nullptr;
+
+    // the dial values stored for the A and B sides of the morph, written on the message thread
+    enum MorphValue { morphDepth = 0, morphPeakTime, morphSpeed, morphFirstFunction, morphSecondFunction, morphCustomShape, numMorphValues };
+    std::array<std::array<std::array<std::atomic<float>, numMorphValues>, 2>, 2> morphSnapshots; // [slot][channel][value]
+
+    void loadMorphSnapshots();
+
+    // the multiband mode, bands 2 to 4 have their own wave, shared by both channels
+    std::atomic<float>* numBandsParam = nullptr;
+    std::array<std::atomic<float>*, 3> crossoverParams{};
+    std::array<std::atomic<float>*, 3> depthBandParams{}, peakTimeBandParams{}, speedBandParams{};
+    std::array<std::atomic<float>*, 3> firstFuncBandParams{}, secondFuncBandParams{};
+
+    // what a MIDI message asks processSamples to do at its sample offset
+    enum MidiEvent { midiNothing = 0, midiRetrigger = 1, midiSpeedChanged = 2 };
+
+    // where the speed comes from when it isn't the speed dials (midiSpeedParam)
+    enum MidiSpeedSource { midiSpeedOff = 0, midiSpeedFromNote, midiSpeedFromModWheel, midiSpeedFromClock };
+
+    float midiSpeed = 0.0f; // in bpm, 0 until a MIDI message has set it
+    int midiClockTicks = 0;
+    juce::int64 midiBeatStart = 0, samplesProcessed = 0;
+
+    int handleMidiMessage(const juce::MidiMessage& message, juce::int64 time);
+    int setMidiSpeed(float newSpeed);
+
+    // the rest of what the audio thread works with, one for each precision like myWaves and myWavesDouble
+    template <typename SampleType>
+    struct ProcessingState
+    {
+        TransientDetector<SampleType> sidechainDetector; // restarts the waves on hits in the sidechain input
+        std::array<std::unique_ptr<juce::dsp::Oversampling<SampleType>>, 2> oversamplers; // 2x and 4x around the gain stage
+        std::array<Crossover<SampleType>, 3> crossovers; // split the signal for the multiband mode, one at the rate of each oversampling factor
+        EnvelopeFollower<SampleType> levelFollower; // how much of the tremolo to apply in the dynamic mode
+        juce::AudioBuffer<SampleType> curveBuffer; // the gains of the main waves, at the gain stage's rate
+        juce::AudioBuffer<SampleType> curveDelayLine; // holds the curve back by the oversampling latency
+        int curveDelay = -1, curveDelayPosition = 0; // -1 until the line has been filled with unity
+    };
+
+    ProcessingState<float>  processingState;
+    ProcessingState<double> processingStateDouble;
+
+    // instances in the same sync group take their position from one process-wide clock
+    SharedClock::Member clockMember;
+
+    template <typename SampleType>
+    bool syncToGroup(std::vector<Waves<SampleType>>& waves, int numSamples);
+
+    int oversamplingChoice = 0, oversamplingFactor = 1; // off, 2x or 4x, and the factor it multiplies the rate by
+    int maxBlockSize = 0;
+
+   #if WAVES_TRACING
+    int traceBuffer = -1; // the audio thread's trace buffer, claimed in prepareToPlay
+   #endif
+
+    // the latency of the oversampling factor in use, reported to the host from the message thread
+    std::atomic<int> oversamplingLatency{ 0 };
+    void handleAsyncUpdate() override;
+
+    // passes the rate the waves and the level follower run at, the host rate times the oversampling factor,
+    // without reallocating anything as prepareToPlay has made room for the highest rate
+    template <typename SampleType>
+    void setRateForFactor(std::vector<Waves<SampleType>>& waves, ProcessingState<SampleType>& state, int factor);
+
+    template <typename SampleType>
+    juce::dsp::Oversampling<SampleType>* updateOversampling(std::vector<Waves<SampleType>>& waves, ProcessingState<SampleType>& state);
+
+    // the custom shape points, guarded by the lock as the message thread writes them and the builder reads them
+    mutable juce::SpinLock customShapeLock;
+    std::vector<juce::Point<float>> customShapePoints;
+    std::atomic<int> customShapeVersion{ 1 };
+
+    // only used on the table builder thread
+    CustomShape builderShape;
+    int builderShapeVersion = 0;
+
+    void loadCustomShape();
+    void buildTables();
+
+    // only used on the table builder thread, the flags are set from the message thread
+    TableCache tableCache;
+    std::atomic<bool> tableCacheEnabled{ true };
+    std::atomic<bool> storeTablesRequested{ false };
+    std::atomic<bool> tablesChangedSinceStore{ false }; // set by the builder, so a save only stores new tables
+
+    WaveTableBuilder tableBuilder{ [this] { buildTables(); } };
+
+    // passes changes to the builder and picks up its tables, waiting for them when rendering offline
+    template <typename SampleType>
+    void updateTables(std::vector<Waves<SampleType>>& waves);
+
+    // shared by the float and double processBlock overloads
+    template <typename SampleType>
+    void processSamples(juce::AudioBuffer<SampleType>& buffer, juce::MidiBuffer& midiMessages,
+                        std::vector<Waves<SampleType>>& waves, ProcessingState<SampleType>& state);
+
+    // in the dynamic mode returns how much of the tremolo to apply at each sample, otherwise nullptr
+    template <typename SampleType>
+    const SampleType* followLevel(const juce::dsp::AudioBlock<SampleType>& gainBlock, ProcessingState<SampleType>& state);
+
+    // the modulation output bus carries the gain curve of the main waves when the host switches it on
+    bool isWritingCurve() const;
+
+    template <typename SampleType>
+    void writeCurveBus(juce::AudioBuffer<SampleType>& buffer, ProcessingState<SampleType>& state, int numCurveChannels);
+
+    // shared by the float and double processBlockBypassed overloads
+    template <typename SampleType>
+    void bypassSamples(juce::AudioBuffer<SampleType>& buffer, std::vector<Waves<SampleType>>& waves,
+                       ProcessingState<SampleType>& state);
+
+    // passes the current parameter values to the waves without regenerating their tables
+    template <typename SampleType>
+    void updateParameters(std::vector<Waves<SampleType>>& waves);
+
+    // sets up one wave from dial values, depth in dB and speed in bpm or Hz
+    template <typename SampleType>
+    void setWave(Waves<SampleType>& wave, float depthDecibels, float speed, float peakTime,
+                 int firstFunction, int secondFunction, bool customShape, bool bandLimited);
+
+    // sets the number of bands and the crossover points
+    template <typename SampleType>
+    void updateCrossover(Crossover<SampleType>& crossover);
 
     /* returns +1 for pos, -1 for neg, 0 for 0 */
     int sgn(float x) { return ((0.0f < x) - (x < 0.0f)); }
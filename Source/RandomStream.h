@@ -0,0 +1,68 @@
+/*
+  ==============================================================================
+
+    RandomStream.h
+    Created: 19 Oct 2026 4:12:30pm
+    Author:  James Muten
+    xoshiro128** random numbers for the audio thread. No allocation and no
+    locks, and the same seed always gives the same stream, so offline
+    bounces come out the same every time.
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+#include <array>
+#include <cstdint>
+
+class RandomStream
+{
+public:
+    explicit RandomStream(std::uint64_t seed = 1) noexcept
+    {
+        setSeed(seed);
+    }
+
+    // the four words of state are filled from the seed with splitmix64, so nearby seeds give unrelated streams
+    void setSeed(std::uint64_t seed) noexcept
+    {
+        for (auto& word : state)
+        {
+            seed += 0x9e3779b97f4a7c15ull;
+            auto z = seed;
+            z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+            z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+            word = (std::uint32_t)((z ^ (z >> 31)) >> 32);
+        }
+    }
+
+    std::uint32_t next() noexcept
+    {
+        const auto result = rotl(state[1] * 5, 7) * 9;
+        const auto t = state[1] << 9;
+
+        state[2] ^= state[0];
+        state[3] ^= state[1];
+        state[1] ^= state[2];
+        state[0] ^= state[3];
+        state[2] ^= t;
+        state[3] = rotl(state[3], 11);
+
+        return result;
+    }
+
+    // between -1 and 1
+    float nextBipolar() noexcept
+    {
+        return (float)(next() >> 8) * (2.0f / 16777216.0f) - 1.0f;
+    }
+
+private:
+    std::array<std::uint32_t, 4> state{};
+
+    static std::uint32_t rotl(std::uint32_t x, int k) noexcept
+    {
+        return (x << k) | (x >> (32 - k));
+    }
+};
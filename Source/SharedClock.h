@@ -0,0 +1,98 @@
+/*
+  ==============================================================================
+
+    SharedClock.h
+    Created: 19 Oct 2026 2:26:33pm
+    Author:  James Muten
+    One sample clock per sync group, shared by every instance of the plugin
+    in the host process. Whichever instance in a group runs first in a block
+    moves the clock on to where the block starts, the others read that start,
+    so all of them see the same position without any locks.
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+#include <array>
+#include <atomic>
+
+class SharedClock
+{
+public:
+    static constexpr int numGroups = 8;
+
+    // what each instance keeps to know whether it is first in a block
+    struct Member
+    {
+        juce::uint64 lastBlock = 0;
+    };
+
+    static SharedClock& getInstance()
+    {
+        static SharedClock clock;
+        return clock;
+    }
+
+    /** Call once per block from every instance in the group (1 to numGroups).
+        Returns the group's sample position at the start of this block. The first instance in a block
+        publishes where the block starts and how long its own block is, and the next block starts that
+        much later, so every instance reads the same start whatever size its own blocks are. */
+    juce::int64 beginBlock(int group, Member& member, int numSamples) noexcept
+    {
+        jassert(numSamples >= 0 && (juce::uint64)numSamples <= lengthMask);
+
+        auto& clock = clocks[(size_t)juce::jlimit(1, numGroups, group) - 1];
+        auto packed = clock.load(std::memory_order_acquire);
+
+        for (;;)
+        {
+            const auto block  = packed >> (lengthBits + startBits);
+            const auto length = (packed >> startBits) & lengthMask;
+            const auto start  = packed & startMask;
+            const auto next   = (member.lastBlock + 1) & blockMask;
+
+            // another instance has already started this block
+            if (block == next)
+            {
+                member.lastBlock = next;
+                return (juce::int64)start;
+            }
+
+            // joined late or missed blocks, so start again from the group's last block
+            if (block != member.lastBlock)
+                member.lastBlock = block;
+
+            // the first in this block, which starts where the group's last block ended
+            const auto nextStart  = (start + length) & startMask;
+            const auto nextPacked = (((block + 1) & blockMask) << (lengthBits + startBits))
+                                  | (juce::jmin((juce::uint64)numSamples, lengthMask) << startBits)
+                                  | nextStart;
+
+            if (clock.compare_exchange_weak(packed, nextPacked, std::memory_order_acq_rel, std::memory_order_acquire))
+            {
+                member.lastBlock = (block + 1) & blockMask;
+                return (juce::int64)nextStart;
+            }
+        }
+    }
+
+private:
+    SharedClock() = default;
+
+    // the block count, the length of the block and where it starts share one word, so they always change
+    // together. The start wraps round after about 400 hours at 192 kHz
+    static constexpr int blockBits  = 8;
+    static constexpr int lengthBits = 18;
+    static constexpr int startBits  = 64 - blockBits - lengthBits;
+
+    static constexpr juce::uint64 blockMask  = (juce::uint64(1) << blockBits) - 1;
+    static constexpr juce::uint64 lengthMask = (juce::uint64(1) << lengthBits) - 1;
+    static constexpr juce::uint64 startMask  = (juce::uint64(1) << startBits) - 1;
+
+    std::array<std::atomic<juce::uint64>, numGroups> clocks{};
+
+    static_assert(std::atomic<juce::uint64>::is_always_lock_free, "the shared clock must be lock-free");
+
+    JUCE_DECLARE_NON_COPYABLE(SharedClock)
+};
@@ -0,0 +1,218 @@
+/*
+  ==============================================================================
+
+    TableCache.h
+    Created: 19 Oct 2026 3:02:48pm
+    Author:  James Muten
+    Keeps generated wave tables on disk so a session that is opened again can
+    play its tables straight out of a memory-mapped file instead of working
+    every sample out again. Only ever used from the table builder thread.
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+class TableCache
+{
+public:
+    // Everything that decides what is in a table
+    struct Key
+    {
+        int    firstFunction = 1, secondFunction = 1;
+        double depth = 0.0;
+        int    maxWaveTimeSample = 0, midWaveTimeSample = 0; // the period and peak time, in samples at the table's rate
+        int    controlInterval = 1; // samples between the points kept
+        int    sampleSize = 0; // float or double tables
+
+        // a point every interval from the start of each half of the cycle
+        int getNumPoints() const noexcept
+        {
+            return (midWaveTimeSample + controlInterval - 1) / controlInterval
+                 + (maxWaveTimeSample - midWaveTimeSample + controlInterval - 1) / controlInterval;
+        }
+
+        bool operator== (const Key& other) const noexcept
+        {
+            return firstFunction == other.firstFunction && secondFunction == other.secondFunction
+                && depth == other.depth
+                && maxWaveTimeSample == other.maxWaveTimeSample && midWaveTimeSample == other.midWaveTimeSample
+                && controlInterval == other.controlInterval && sampleSize == other.sampleSize;
+        }
+    };
+
+    // Change this whenever the generators change, so tables from older versions are ignored
+    static constexpr int generatorVersion = 2;
+
+    static constexpr juce::int64 defaultMaxBytes = 64 * 1024 * 1024;
+
+    explicit TableCache(juce::File cacheDirectory = getDefaultDirectory(), juce::int64 maxBytesToKeep = defaultMaxBytes)
+        : directory(std::move(cacheDirectory)), maxBytes(maxBytesToKeep)
+    {
+    }
+
+    static juce::File getDefaultDirectory()
+    {
+        return juce::File::getSpecialLocation(juce::File::userApplicationDataDirectory)
+            .getChildFile("Muten Audio").getChildFile("Waves").getChildFile("TableCache");
+    }
+
+    /** A table read in place from its memory-mapped file. The file stays mapped for as long as a copy
+        of this is held, so the table can be played straight out of the mapping. */
+    template <typename Type>
+    struct MappedTable
+    {
+        std::shared_ptr<const juce::MemoryMappedFile> file;
+        const Type* values = nullptr;
+        size_t numPoints = 0;
+
+        explicit operator bool() const noexcept { return values != nullptr; }
+    };
+
+    /** Maps the key's table from the cache without copying it.
+        Returns an empty table if it isn't cached or the file doesn't match. */
+    template <typename Type>
+    MappedTable<Type> load(const Key& key)
+    {
+        jassert(key.sampleSize == (int)sizeof(Type));
+
+        auto file = getFile(key);
+        if (! file.existsAsFile())
+            return {};
+
+        auto mapped = std::make_shared<const juce::MemoryMappedFile>(file, juce::MemoryMappedFile::readOnly);
+        const auto numPoints = (size_t)key.getNumPoints();
+
+        if (mapped->getData() == nullptr || mapped->getSize() != (size_t)headerSize + numPoints * sizeof(Type))
+            return {};
+
+        if (! readHeader(mapped->getData(), key))
+            return {};
+
+        // the modification time is the last session that used it, for the eviction order
+        if (touchedFiles.addIfNotAlreadyThere(file.getFullPathName()))
+            file.setLastModificationTime(juce::Time::getCurrentTime());
+
+        // the mapping starts on a page, and the header keeps the values after it aligned
+        const auto* values = reinterpret_cast<const Type*>(static_cast<const char*>(mapped->getData()) + headerSize);
+        return { std::move(mapped), values, numPoints };
+    }
+
+    // Writes the table to the cache, then drops the least recently used tables if it is over size
+    template <typename Type>
+    void store(const Key& key, const std::vector<Type>& table)
+    {
+        jassert(key.sampleSize == (int)sizeof(Type) && table.size() == (size_t)key.getNumPoints());
+
+        auto file = getFile(key);
+        if (file.existsAsFile() || ! directory.createDirectory())
+            return;
+
+        // written next to the final file and moved into place, so a half-written table is never read
+        juce::TemporaryFile temporary(file);
+        {
+            juce::FileOutputStream stream(temporary.getFile());
+            if (! stream.openedOk())
+                return;
+
+            writeHeader(stream, key);
+            stream.write(table.data(), table.size() * sizeof(Type));
+        }
+
+        if (temporary.overwriteTargetFileWithTemporary())
+            evict();
+    }
+
+private:
+    static constexpr juce::uint32 magicNumber = 0x57764362; // "WvCb"
+
+    // the magic number, the version and the key, written a field at a time so no padding goes in the file
+    static constexpr int headerSize = 2 * 4 + 2 * 4 + 8 + 4 * 4;
+
+    static_assert(headerSize % alignof(double) == 0, "the values after the header have to stay aligned");
+
+    juce::File directory;
+    juce::int64 maxBytes;
+    juce::StringArray touchedFiles; // the files whose use has been noted this session
+
+    // the generator version and the size of the header, so a build with a different header doesn't read it
+    static juce::uint32 getVersionHash() noexcept
+    {
+        return (juce::uint32)juce::String(juce::String(generatorVersion) + ":" + juce::String(headerSize)).hashCode();
+    }
+
+    static void writeHeader(juce::FileOutputStream& stream, const Key& key)
+    {
+        stream.writeInt((int)magicNumber);
+        stream.writeInt((int)getVersionHash());
+        stream.writeInt(key.firstFunction);
+        stream.writeInt(key.secondFunction);
+        stream.writeDouble(key.depth);
+        stream.writeInt(key.maxWaveTimeSample);
+        stream.writeInt(key.midWaveTimeSample);
+        stream.writeInt(key.controlInterval);
+        stream.writeInt(key.sampleSize);
+    }
+
+    // True if the header is this version's and was written for the key
+    static bool readHeader(const void* data, const Key& key)
+    {
+        juce::MemoryInputStream stream(data, (size_t)headerSize, false);
+
+        if ((juce::uint32)stream.readInt() != magicNumber || (juce::uint32)stream.readInt() != getVersionHash())
+            return false;
+
+        Key stored;
+        stored.firstFunction     = stream.readInt();
+        stored.secondFunction    = stream.readInt();
+        stored.depth             = stream.readDouble();
+        stored.maxWaveTimeSample = stream.readInt();
+        stored.midWaveTimeSample = stream.readInt();
+        stored.controlInterval   = stream.readInt();
+        stored.sampleSize        = stream.readInt();
+
+        return stored == key;
+    }
+
+    juce::File getFile(const Key& key) const
+    {
+        const auto name = juce::String(key.firstFunction) + "_" + juce::String(key.secondFunction) + "_"
+                        + juce::String(key.depth, 12) + "_" + juce::String(key.maxWaveTimeSample) + "_"
+                        + juce::String(key.midWaveTimeSample) + "_" + juce::String(key.controlInterval) + "_"
+                        + juce::String(key.sampleSize);
+
+        return directory.getChildFile(juce::String::toHexString(name.hashCode64()) + ".table");
+    }
+
+    void evict()
+    {
+        auto files = directory.findChildFiles(juce::File::findFiles, false, "*.table");
+
+        juce::int64 totalBytes = 0;
+        for (auto& file : files)
+            totalBytes += file.getSize();
+
+        if (totalBytes <= maxBytes)
+            return;
+
+        std::sort(files.begin(), files.end(), [](const juce::File& a, const juce::File& b)
+        {
+            return a.getLastModificationTime() < b.getLastModificationTime();
+        });
+
+        for (auto& file : files)
+        {
+            if (totalBytes <= maxBytes)
+                break;
+
+            totalBytes -= file.getSize();
+            file.deleteFile();
+        }
+    }
+
+    JUCE_DECLARE_NON_COPYABLE(TableCache)
+};
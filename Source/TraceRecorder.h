@@ -0,0 +1,221 @@
+/*
+  ==============================================================================
+
+    TraceRecorder.h
+    Created: 19 Oct 2026 6:24:09pm
+    Author:  James Muten
+    Records timed spans from the audio, builder and message threads and
+    writes them out as a Chrome trace (chrome://tracing or ui.perfetto.dev),
+    to see what happened in the block that spiked rather than an average.
+    Only compiled in with WAVES_TRACING=1 in the preprocessor definitions,
+    otherwise WAVES_TRACE_SCOPE is nothing at all.
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+#include <array>
+#include <atomic>
+#include <memory>
+
+#ifndef WAVES_TRACING
+ #define WAVES_TRACING 0
+#endif
+
+#if WAVES_TRACING
+ // times from here to the end of the enclosing scope, the name must be a string literal
+ #define WAVES_TRACE_SCOPE(name) const TraceRecorder::ScopedSpan JUCE_JOIN_MACRO(traceSpan, __LINE__) (name)
+ // the same into a buffer claimed beforehand, for the audio thread
+ #define WAVES_TRACE_SCOPE_IN(buffer, name) const TraceRecorder::ScopedSpan JUCE_JOIN_MACRO(traceSpan, __LINE__) (buffer, name)
+#else
+ #define WAVES_TRACE_SCOPE(name)
+ #define WAVES_TRACE_SCOPE_IN(buffer, name)
+#endif
+
+#if WAVES_TRACING
+
+class TraceRecorder
+{
+public:
+    //==============================================================================================
+    static constexpr int maxThreads      = 16;
+    static constexpr int eventsPerThread = 8192; // a power of two, the oldest spans are overwritten
+
+    // Everything is allocated here, so call it off the audio thread before the first span
+    static TraceRecorder& getInstance()
+    {
+        static TraceRecorder recorder;
+        return recorder;
+    }
+
+    /** Takes a buffer for a thread that must not claim one itself, such as the audio thread, where the
+        first use of a thread_local can allocate. Call it off that thread, from prepareToPlay. Returns -1
+        if every buffer is taken. The name must be a string literal. */
+    int claimBuffer(const char* threadName) noexcept
+    {
+        const auto index = numThreads.fetch_add(1, std::memory_order_relaxed);
+        if (index >= maxThreads)
+            return -1;
+
+        auto& buffer = (*buffers)[(size_t)index];
+        buffer.name = threadName;
+        buffer.claimed.store(true, std::memory_order_release);
+        return index;
+    }
+
+    // Adds a finished span to the calling thread's own buffer, claiming one the first time
+    void record(const char* name, juce::int64 startTicks, juce::int64 endTicks) noexcept
+    {
+        record(getThreadBuffer(), name, startTicks, endTicks);
+    }
+
+    /** Adds a finished span to a claimed buffer. Each buffer has only one writer, which fills in the
+        event and then publishes it with a release store of the head, no locks and no allocation. */
+    void record(int bufferIndex, const char* name, juce::int64 startTicks, juce::int64 endTicks) noexcept
+    {
+        if (bufferIndex < 0 || bufferIndex >= maxThreads)
+            return; // more threads than buffers, these spans are dropped
+
+        auto& buffer = (*buffers)[(size_t)bufferIndex];
+        const auto head = buffer.head.load(std::memory_order_relaxed);
+        auto& event = buffer.events[(size_t)(head & (eventsPerThread - 1))];
+
+        event.name.store(name, std::memory_order_relaxed);
+        event.start.store(startTicks, std::memory_order_relaxed);
+        event.end.store(endTicks, std::memory_order_relaxed);
+        buffer.head.store(head + 1, std::memory_order_release);
+    }
+
+    class ScopedSpan
+    {
+    public:
+        explicit ScopedSpan(const char* spanName) noexcept
+            : name(spanName), start(juce::Time::getHighResolutionTicks()) {}
+
+        ScopedSpan(int claimedBuffer, const char* spanName) noexcept
+            : buffer(claimedBuffer), claimed(true), name(spanName), start(juce::Time::getHighResolutionTicks()) {}
+
+        ~ScopedSpan()
+        {
+            const auto end = juce::Time::getHighResolutionTicks();
+
+            if (claimed)
+                TraceRecorder::getInstance().record(buffer, name, start, end);
+            else
+                TraceRecorder::getInstance().record(name, start, end);
+        }
+
+    private:
+        int buffer = -1;
+        bool claimed = false;
+        const char* name;
+        juce::int64 start;
+
+        JUCE_DECLARE_NON_COPYABLE(ScopedSpan)
+    };
+
+    /** The spans still in the buffers as Chrome trace JSON, times in microseconds from when the
+        recorder was made. Safe to call while recording, spans overwritten during the copy are left out. */
+    juce::String toChromeTraceJson() const
+    {
+        juce::MemoryOutputStream json;
+        json << "{\"traceEvents\":[";
+        bool first = true;
+
+        auto toMicroseconds = [this](juce::int64 ticks)
+        {
+            return juce::Time::highResolutionTicksToSeconds(ticks - originTicks) * 1.0e6;
+        };
+
+        for (int thread = 0; thread < maxThreads; thread++)
+        {
+            const auto& buffer = (*buffers)[(size_t)thread];
+            if (! buffer.claimed.load(std::memory_order_acquire))
+                continue;
+
+            // the acquire pairs with the writer's release, so every event before the head is filled in
+            const auto end   = buffer.head.load(std::memory_order_acquire);
+            const auto begin = end > (juce::uint64)eventsPerThread ? end - (juce::uint64)eventsPerThread : 0;
+
+            struct Copy { const char* name; juce::int64 start, end; };
+            std::vector<Copy> events;
+            events.reserve((size_t)(end - begin));
+            for (auto i = begin; i < end; i++)
+            {
+                const auto& event = buffer.events[(size_t)(i & (eventsPerThread - 1))];
+                events.push_back({ event.name.load(std::memory_order_relaxed),
+                                   event.start.load(std::memory_order_relaxed),
+                                   event.end.load(std::memory_order_relaxed) });
+            }
+
+            // the writer may have lapped the copy, so only keep what it can't have reached
+            std::atomic_thread_fence(std::memory_order_acquire);
+            const auto lapped = buffer.head.load(std::memory_order_relaxed);
+            const auto firstSafe = lapped > (juce::uint64)eventsPerThread ? lapped - (juce::uint64)eventsPerThread : 0;
+
+            json << (first ? "" : ",") << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << (thread + 1)
+                 << ",\"args\":{\"name\":\"" << (buffer.name != nullptr ? juce::String(buffer.name)
+                                                                       : "thread " + juce::String(thread + 1)) << "\"}}";
+            first = false;
+
+            for (auto i = juce::jmax(begin, firstSafe); i < end; i++)
+            {
+                const auto& event = events[(size_t)(i - begin)];
+                json << ",{\"name\":\"" << event.name << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << (thread + 1)
+                     << ",\"ts\":" << juce::String(toMicroseconds(event.start), 3)
+                     << ",\"dur\":" << juce::String(toMicroseconds(event.end) - toMicroseconds(event.start), 3) << "}";
+            }
+        }
+
+        json << "]}";
+        return json.toString();
+    }
+
+    bool writeChromeTrace(const juce::File& file) const
+    {
+        return file.replaceWithText(toChromeTraceJson());
+    }
+
+private:
+    // atomics so a reader copying an event the writer is overwriting isn't a data race, the copy is dropped
+    struct Event
+    {
+        std::atomic<const char*> name{ nullptr };
+        std::atomic<juce::int64> start{ 0 }, end{ 0 };
+    };
+
+    struct ThreadBuffer
+    {
+        std::atomic<juce::uint64> head{ 0 }; // spans ever written, the next one goes at head % eventsPerThread
+        std::atomic<bool> claimed{ false };  // published after the name
+        const char* name = nullptr;          // nullptr shows as the thread's number
+        std::array<Event, eventsPerThread> events;
+    };
+
+    std::unique_ptr<std::array<ThreadBuffer, maxThreads>> buffers{ std::make_unique<std::array<ThreadBuffer, maxThreads>>() };
+    std::atomic<int> numThreads{ 0 };
+    const juce::int64 originTicks = juce::Time::getHighResolutionTicks();
+
+    TraceRecorder() = default;
+
+    /** Any other thread takes the next buffer the first time it records, after that it is a thread_local
+        read. Never used on the audio thread, which records into the buffer it was given. */
+    int getThreadBuffer() noexcept
+    {
+        static thread_local int buffer = -1;
+        static thread_local bool claimed = false;
+
+        if (! claimed)
+        {
+            claimed = true;
+            buffer  = claimBuffer(juce::MessageManager::existsAndIsCurrentThread() ? "message thread" : nullptr);
+        }
+
+        return buffer;
+    }
+
+    JUCE_DECLARE_NON_COPYABLE(TraceRecorder)
+};
+
+#endif
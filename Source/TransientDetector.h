@@ -0,0 +1,138 @@
+/*
+  ==============================================================================
+
+    TransientDetector.h
+    Created: 19 Oct 2026 10:12:41am
+    Author:  James Muten
+    Finds onsets in the sidechain input, giving their sample offsets within
+    the block so the waves can be restarted exactly on the hit
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+#include "LevelDetection.h"
+#include <array>
+#include <cmath>
+
+template <typename Type>
+class TransientDetector
+{
+public:
+    //==============================================================================================
+    static constexpr int maxTriggersPerBlock = 32;
+
+    void prepare(const juce::dsp::ProcessSpec& spec)
+    {
+        sampleRate = spec.sampleRate;
+        blockSize  = (int)spec.maximumBlockSize;
+
+        rectified.resize(blockSize);
+        fastEnvelope.resize(blockSize);
+        slowEnvelope.resize(blockSize);
+
+        fastAttack  = coefficient(0.0005);
+        fastRelease = coefficient(0.02);
+        slowCoeff   = coefficient(0.15);
+        holdSamples = (int)std::ceil(0.05 * sampleRate); // at most one trigger every 50 ms
+
+        reset();
+    }
+
+    void reset() noexcept
+    {
+        fast = slow = Type(0);
+        armed = true;
+        samplesSinceTrigger = holdSamples;
+    }
+
+    // How far the fast envelope has to jump above the slow one to count as a hit
+    void setThreshold(Type decibels) noexcept
+    {
+        ratio = std::pow(Type(10), decibels / Type(20));
+    }
+
+    /** Looks for transients in the given channels and returns the number found.
+        Their offsets are in ascending order in getTriggerOffsets(). */
+    int process(const Type* const* channels, int numChannels, int numSamples) noexcept
+    {
+        numTriggers = 0;
+
+        if (blockSize == 0) // not prepared yet
+            return 0;
+
+        for (int start = 0; start < numSamples; start += blockSize)
+            processChunk(channels, numChannels, start, std::min(blockSize, numSamples - start));
+
+        return numTriggers;
+    }
+
+    const int* getTriggerOffsets() const noexcept
+    {
+        return triggerOffsets.data();
+    }
+
+private:
+    double sampleRate = 44.1e3;
+    int    blockSize  = 0;
+
+    std::vector<Type> rectified, fastEnvelope, slowEnvelope;
+
+    Type fastAttack{ 0 }, fastRelease{ 0 }, slowCoeff{ 0 };
+    Type fast{ 0 }, slow{ 0 };
+    Type ratio{ 2 };
+    static constexpr Type floor = Type(0.001); // -60 dB, nothing quieter than this is a hit
+
+    bool armed = true;
+    int  holdSamples = 0, samplesSinceTrigger = 0;
+
+    std::array<int, maxTriggersPerBlock> triggerOffsets{};
+    int numTriggers = 0;
+
+    Type coefficient(double seconds) const
+    {
+        return (Type)(1.0 - std::exp(-1.0 / (seconds * sampleRate)));
+    }
+
+    void processChunk(const Type* const* channels, int numChannels, int start, int numSamples) noexcept
+    {
+        // the slow envelope is written after this, so it makes the scratch space
+        rectifyLoudest(rectified.data(), slowEnvelope.data(), channels, numChannels, start, numSamples);
+
+        // the envelopes are recursive so they have to run sample by sample, but each one is a tight loop on its own
+        for (int i = 0; i < numSamples; i++)
+        {
+            auto x = rectified[i];
+            fast += (x > fast ? fastAttack : fastRelease) * (x - fast);
+            fastEnvelope[i] = fast;
+        }
+
+        for (int i = 0; i < numSamples; i++)
+        {
+            slow += slowCoeff * (rectified[i] - slow);
+            slowEnvelope[i] = slow;
+        }
+
+        // positive wherever the fast envelope is above the slow one by the threshold,
+        // the rectified signal isn't needed any more so it holds the difference
+        juce::FloatVectorOperations::copy(rectified.data(), fastEnvelope.data(), numSamples);
+        juce::FloatVectorOperations::addWithMultiply(rectified.data(), slowEnvelope.data(), -ratio, numSamples);
+
+        for (int i = 0; i < numSamples; i++, samplesSinceTrigger++)
+        {
+            const bool above = rectified[i] > Type(0) && fastEnvelope[i] > floor;
+
+            if (! above)
+            {
+                armed = true;
+            }
+            else if (armed && samplesSinceTrigger >= holdSamples && numTriggers < maxTriggersPerBlock)
+            {
+                triggerOffsets[numTriggers++] = start + i;
+                armed = false;
+                samplesSinceTrigger = 0;
+            }
+        }
+    }
+};
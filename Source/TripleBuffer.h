@@ -0,0 +1,75 @@
+/*
+  ==============================================================================
+
+    TripleBuffer.h
+    Created: 19 Oct 2026 11:02:17am
+    Author:  James Muten
+    Hands the newest value from one thread to another without locks.
+    One thread writes and publishes, one other thread acquires and reads,
+    and neither ever waits for the other.
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+#include <array>
+#include <atomic>
+
+template <typename Type>
+class TripleBuffer
+{
+public:
+    //==============================================================================================
+    TripleBuffer() = default;
+
+    // Sets all three buffers, only while no other thread is using this
+    void fill(const Type& value)
+    {
+        for (auto& buffer : buffers)
+            buffer = value;
+    }
+
+    //==============================================================================================
+    // writer thread
+
+    Type& getWriteBuffer() noexcept
+    {
+        return buffers[writeIndex];
+    }
+
+    // Makes the write buffer the newest value and takes the spare one to write into next
+    void publish() noexcept
+    {
+        writeIndex = middle.exchange(writeIndex | freshBit, std::memory_order_acq_rel) & indexMask;
+    }
+
+    //==============================================================================================
+    // reader thread
+
+    // Swaps in the newest published value, returns false if nothing new has been published
+    bool acquire() noexcept
+    {
+        if ((middle.load(std::memory_order_acquire) & freshBit) == 0)
+            return false;
+
+        readIndex = middle.exchange(readIndex, std::memory_order_acq_rel) & indexMask;
+        return true;
+    }
+
+    const Type& getReadBuffer() const noexcept
+    {
+        return buffers[readIndex];
+    }
+
+private:
+    static constexpr int indexMask = 3;
+    static constexpr int freshBit  = 4;
+
+    std::array<Type, 3> buffers;
+    int writeIndex = 0;
+    int readIndex  = 1;
+    std::atomic<int> middle{ 2 };
+
+    JUCE_DECLARE_NON_COPYABLE(TripleBuffer)
+};
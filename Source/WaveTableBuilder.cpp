@@ -0,0 +1,230 @@
+/*
+  ==============================================================================
+
+    WaveTableBuilder.cpp
+    Created: 19 Oct 2026 9:18:52pm
+    Author:  James Muten
+    The thread shared by every instance's table builder, and the semaphore
+    the audio threads wake it with. The semaphore is the platform's own,
+    which posts without taking a lock, so it is kept out of the header.
+
+  ==============================================================================
+*/
+
+#include "WaveTableBuilder.h"
+
+#if JUCE_MAC || JUCE_IOS
+ #include <dispatch/dispatch.h>
+#elif JUCE_WINDOWS
+ #ifndef NOMINMAX
+  #define NOMINMAX
+ #endif
+ #include <windows.h>
+#else
+ #include <cerrno>
+ #include <semaphore.h>
+#endif
+
+namespace
+{
+    // post() is a single atomic operation unless the thread is asleep, when the kernel wakes it
+    class WakeUpSemaphore
+    {
+    public:
+        WakeUpSemaphore()
+        {
+           #if JUCE_MAC || JUCE_IOS
+            semaphore = dispatch_semaphore_create(0);
+           #elif JUCE_WINDOWS
+            semaphore = CreateSemaphoreW(nullptr, 0, 0x7fffffff, nullptr);
+           #else
+            sem_init(&semaphore, 0, 0);
+           #endif
+        }
+
+        ~WakeUpSemaphore()
+        {
+           #if JUCE_MAC || JUCE_IOS
+            dispatch_release(semaphore);
+           #elif JUCE_WINDOWS
+            CloseHandle(semaphore);
+           #else
+            sem_destroy(&semaphore);
+           #endif
+        }
+
+        void post() noexcept
+        {
+           #if JUCE_MAC || JUCE_IOS
+            dispatch_semaphore_signal(semaphore);
+           #elif JUCE_WINDOWS
+            ReleaseSemaphore(semaphore, 1, nullptr);
+           #else
+            sem_post(&semaphore);
+           #endif
+        }
+
+        void wait() noexcept
+        {
+           #if JUCE_MAC || JUCE_IOS
+            dispatch_semaphore_wait(semaphore, DISPATCH_TIME_FOREVER);
+           #elif JUCE_WINDOWS
+            WaitForSingleObject(semaphore, INFINITE);
+           #else
+            while (sem_wait(&semaphore) != 0 && errno == EINTR) {}
+           #endif
+        }
+
+    private:
+       #if JUCE_MAC || JUCE_IOS
+        dispatch_semaphore_t semaphore;
+       #elif JUCE_WINDOWS
+        HANDLE semaphore;
+       #else
+        sem_t semaphore;
+       #endif
+
+        JUCE_DECLARE_NON_COPYABLE(WakeUpSemaphore)
+    };
+}
+
+//==================================================================================================
+class WaveTableBuilder::SharedThread : public juce::Thread
+{
+public:
+    SharedThread() : juce::Thread("Waves table builder") {}
+
+    ~SharedThread() override
+    {
+        signalThreadShouldExit();
+        wakeUp.post();
+        stopThread(1000);
+    }
+
+    // the running thread, started for the first instance and stopped when the last one lets go of it
+    static std::shared_ptr<SharedThread> getInstance()
+    {
+        static juce::CriticalSection instanceLock;
+        static std::weak_ptr<SharedThread> instance;
+
+        const juce::ScopedLock lock(instanceLock);
+        auto thread = instance.lock();
+        if (thread == nullptr)
+        {
+            thread = std::make_shared<SharedThread>();
+            thread->startThread();
+            instance = thread;
+        }
+
+        return thread;
+    }
+
+    void add(WaveTableBuilder* builder)
+    {
+        const juce::ScopedLock lock(buildersLock);
+        builders.addIfNotAlreadyThere(builder);
+    }
+
+    // the builds run under the same lock, so once this returns none of this builder's is running
+    void remove(WaveTableBuilder* builder)
+    {
+        const juce::ScopedLock lock(buildersLock);
+        builders.removeFirstMatchingValue(builder);
+    }
+
+    // only the first request since the thread last woke posts, the rest find it already on its way
+    void wake() noexcept
+    {
+        if (! wakePending.exchange(true, std::memory_order_acq_rel))
+            wakeUp.post();
+    }
+
+    void run() override
+    {
+        while (! threadShouldExit())
+        {
+            wakeUp.wait();
+            wakePending.store(false, std::memory_order_release);
+
+            const juce::ScopedLock lock(buildersLock);
+            for (auto* builder : builders)
+                builder->buildIfRequested();
+        }
+    }
+
+private:
+    WakeUpSemaphore wakeUp;
+    std::atomic<bool> wakePending{ false };
+
+    juce::CriticalSection buildersLock;
+    juce::Array<WaveTableBuilder*> builders;
+
+    JUCE_DECLARE_NON_COPYABLE(SharedThread)
+};
+
+//==================================================================================================
+WaveTableBuilder::WaveTableBuilder(std::function<void()> buildFunction)
+    : build(std::move(buildFunction))
+{
+}
+
+WaveTableBuilder::~WaveTableBuilder()
+{
+    stop();
+}
+
+void WaveTableBuilder::start()
+{
+    if (sharedThread != nullptr)
+        return;
+
+    sharedThread = SharedThread::getInstance();
+    sharedThread->add(this);
+    sharedThread->wake(); // for anything asked for before starting
+}
+
+void WaveTableBuilder::stop()
+{
+    if (sharedThread == nullptr)
+        return;
+
+    sharedThread->remove(this);
+    sharedThread.reset();
+}
+
+void WaveTableBuilder::requestBuild() noexcept
+{
+    ++requestedBuilds;
+
+    if (sharedThread != nullptr)
+        sharedThread->wake();
+}
+
+void WaveTableBuilder::waitForBuild(int timeoutMs)
+{
+    const auto wanted = requestedBuilds.load();
+    const auto start  = juce::Time::getMillisecondCounter();
+
+    if (sharedThread != nullptr)
+        sharedThread->wake();
+
+    while ((int)(finishedBuilds.load() - wanted) < 0)
+    {
+        const auto elapsed = (int)(juce::Time::getMillisecondCounter() - start);
+        if (elapsed >= timeoutMs)
+            break;
+
+        buildFinished.wait(timeoutMs - elapsed);
+    }
+}
+
+void WaveTableBuilder::buildIfRequested()
+{
+    const auto wanted = requestedBuilds.load();
+    if (wanted == finishedBuilds.load())
+        return;
+
+    build();
+    finishedBuilds = wanted;
+    buildFinished.signal();
+}
@@ -0,0 +1,52 @@
+/*
+  ==============================================================================
+
+    WaveTableBuilder.h
+    Created: 19 Oct 2026 11:06:40am
+    Author:  James Muten
+    Renders the wave tables in the background, so the audio thread only
+    ever has to ask for a new table and pick it up when it's ready. One
+    thread is shared by every instance of the plugin in the host process,
+    and sleeps until an instance asks for a build.
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+#include <atomic>
+#include <functional>
+#include <memory>
+
+class WaveTableBuilder
+{
+public:
+    explicit WaveTableBuilder(std::function<void()> buildFunction);
+    ~WaveTableBuilder();
+
+    // Adds this instance's build to the shared thread, starting the thread for the first instance
+    void start();
+
+    // Takes it off again, after any build of it that is running, and stops the thread after the last instance
+    void stop();
+
+    // Safe to call from the audio thread, a counter and a semaphore post, no locks and no allocation
+    void requestBuild() noexcept;
+
+    /** Waits until everything asked for so far has been built. Only for offline rendering, where the
+        audio thread is allowed to block, so new tables arrive at the same sample on every bounce. */
+    void waitForBuild(int timeoutMs = 1000);
+
+private:
+    class SharedThread;
+
+    std::function<void()> build;
+    std::atomic<juce::uint32> requestedBuilds{ 0 }, finishedBuilds{ 0 };
+    juce::WaitableEvent buildFinished; // only waited on offline
+    std::shared_ptr<SharedThread> sharedThread; // keeps the thread running while this is started
+
+    // on the shared thread, builds if anything has been asked for since the last build
+    void buildIfRequested();
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(WaveTableBuilder)
+};
@@ -11,46 +11,1130 @@
 
 #pragma once
 #include <JuceHeader.h>
+#include <algorithm>
+#include <array>
 #include <cmath>
+#include "CustomShape.h"
+#include "TripleBuffer.h"
+#include "TableCache.h"
+#include "RandomStream.h"
+#include "TraceRecorder.h"
 
 template <typename Type>
 class Waves
 {
 public:
+    // Audio rate waves are read from band-limited copies of one cycle at this resolution
+    static constexpr int bandLimitedOrder     = 11;
+    static constexpr int bandLimitedTableSize = 1 << bandLimitedOrder;
+    static constexpr int numBandLimitedLevels = bandLimitedOrder; // 1024 harmonics down to 1
+
+    // Everything the table builder needs to render a table, sent from the audio thread
+    struct TableRequest
+    {
+        Type depth{ 0 };
+        int  maxWaveTimeSample = 2;
+        int  midWaveTimeSample = 1;
+        int  firstFunction = 1, secondFunction = 1;
+        bool customShape = false;
+        int  customShapeVersion = 0;
+        bool bandLimited = false;
+        int  tableCapacity = 0; // the longest table at the current sample rate
+        int  controlInterval = 1; // samples between the points of the table, ramped between at control rate
+        bool compact = false; // kept as 16 bit codes and decoded in the gain pass
+        int  seedGeneration = 0; // which seeding a randomised table's variation was drawn after
+
+        bool operator== (const TableRequest& other) const noexcept
+        {
+            return depth == other.depth && seedGeneration == other.seedGeneration
+                && maxWaveTimeSample == other.maxWaveTimeSample && midWaveTimeSample == other.midWaveTimeSample
+                && firstFunction == other.firstFunction && secondFunction == other.secondFunction
+                && customShape == other.customShape && customShapeVersion == other.customShapeVersion
+                && bandLimited == other.bandLimited && tableCapacity == other.tableCapacity
+                && controlInterval == other.controlInterval && compact == other.compact;
+        }
+
+        bool operator!= (const TableRequest& other) const noexcept { return ! (*this == other); }
+    };
+
     //==============================================================================================
     Waves()
     {
-        resize(1);// minimum size set on construction?
-        clear();
+        // unity until the first table has been built, so the audio passes straight through
+        tables.fill(Table{ std::vector<Type>(1, Type(1)), 1, 1, 0 });
+        displayTable.assign(1, Type(1));
     }
 
+    /** Sets the sample rate and what depends on it. The longest table at this rate is sent to
+        the builder, so it reserves the space once rather than every time the speed slows down. */
     void prepare(const juce::dsp::ProcessSpec& spec)
     {
-        sampleRate = (float)spec.sampleRate;
-        updateWaveArraySize();
-        //updateWaveTime();
+        sampleRate        = (Type)spec.sampleRate;
+        inverseSampleRate = 1.0 / spec.sampleRate;
+
+        auto request = requested;
+        request.tableCapacity = (int)std::ceil(longestPeriod * spec.sampleRate) + 1;
+        setRequest(request);
+
+        setSampleRate(spec.sampleRate);
     }
 
-    // returns a volume
-    float get(int sample)
+    /** Moves the wave to another rate without reallocating anything, so it is safe on the audio thread.
+        The tables are only as long as prepare() made room for, so prepare at the highest rate first. */
+    void setSampleRate(double newSampleRate) noexcept
     {
-        return waveArrays[sample];
+        sampleRate        = (Type)newSampleRate;
+        inverseSampleRate = 1.0 / newSampleRate;
+
+        if (maxWaveTime > Type(0))
+            setParameters(baseDepth, maxWaveTime, midWaveTime);
     }
 
+    //==============================================================================================
+    // audio thread
+
     // Place all parameters from the processor in one go
-    void setParameters(float newDepth, float newTotalTime, float newPeakTime)
+    void setParameters(Type newDepth, Type newTotalTime, Type newPeakTime)
     {
-        depth       = newDepth;
+        baseDepth   = newDepth;
         maxWaveTime = newTotalTime;
         midWaveTime = newPeakTime;
+        phaseIncrement = inverseSampleRate / (double)maxWaveTime;
+
+        updateRequest();
+    }
+
+    /** Varies the depth, peak time and speed of every cycle by up to the amount, 0 for none.
+        Each cycle's table is built while the one before it plays and is swapped in exactly at the
+        start of the cycle. Band-limited waves aren't varied. */
+    void setRandomisation(Type amount)
+    {
+        if (amount == randomAmount)
+            return;
+
+        randomAmount = amount;
+        if (maxWaveTime > Type(0))
+            updateRequest();
+    }
+
+    /** Restarts the variations, the same seed always gives the same variations. A randomised wave
+        swaps to the table of the seed's first variation as soon as it is built and starts its cycle
+        over on it, rather than finishing a cycle drawn from the old seed first. */
+    void setRandomSeed(std::uint64_t seed)
+    {
+        random.setSeed(seed);
+        drawVariation();
+        seedGeneration++;
+        restartPending = true;
+
+        if (maxWaveTime > Type(0))
+            updateRequest();
+    }
+
+    /** Keeps one point of the table every few samples and ramps the gain between them, the gap
+        chosen from the speed and depth so the ramps stay within controlRateTolerance of the shape.
+        Slow waves then need a fraction of the memory and rendering. Drawn shapes and band-limited
+        waves always have a point every sample. */
+    void setControlRate(bool shouldUseControlRate)
+    {
+        if (shouldUseControlRate == controlRate)
+            return;
+
+        controlRate = shouldUseControlRate;
+        if (maxWaveTime > Type(0))
+            updateRequest();
+    }
+
+    /** Keeps per-sample tables as 16 bit codes between the lowest and highest gain of the table, half the
+        memory of float tables and a quarter of double ones, and half the reading in the gain pass. The codes
+        are within compactTolerance of the shape, far below anything audible. Tables at control rate are
+        already a fraction of the size, and band-limited waves read their own tables, so neither is packed. */
+    void setCompactStorage(bool shouldCompact)
+    {
+        if (shouldCompact == compactStorage)
+            return;
+
+        compactStorage = shouldCompact;
+        if (maxWaveTime > Type(0))
+            updateRequest();
+    }
+
+    /** Reads the wave from band-limited tables with a fractional phase, for audio rate modulation
+        where a table of whole samples would be out of tune and the sharp corners would alias.
+        Call before setParameters(). */
+    void setBandLimited(bool shouldBandLimit)
+    {
+        if (shouldBandLimit == requested.bandLimited)
+            return;
+
+        // carry the phase over to the other way of reading the wave
+        if (shouldBandLimit)
+            phase = (double)(currentSample % size()) / size();
+        else
+            currentSample = (size_t)(phase * size());
+
+        auto request = requested;
+        request.bandLimited = shouldBandLimit;
+        setRequest(request);
+    }
+
+    // Choose the first and second functions, the table is rebuilt once updateTable() sends the change
+    void setFunctions(int first, int second)
+    {
+        auto request = requested;
+        request.firstFunction  = first;
+        request.secondFunction = second;
+        setRequest(request);
+    }
+
+    // Use the user-drawn shape instead of the functions, the version changes whenever the shape is edited
+    void setCustomShape(bool useCustomShape, int shapeVersion)
+    {
+        auto request = requested;
+        request.customShape        = useCustomShape;
+        request.customShapeVersion = useCustomShape ? shapeVersion : 0;
+        setRequest(request);
+
+        // drawn shapes don't use control rate, so the gap between points may change
+        if (maxWaveTime > Type(0))
+            updateRequest();
+    }
+
+    /** Sends any changed parameters to the table builder and swaps in the newest table it has
+        finished, keeping the phase where it was. Returns true if the builder has new work to do. */
+    bool updateTable() noexcept
+    {
+        // randomised tables only change at the start of a cycle, see startNextCycle(), or after reseeding
+        if (! holdsTablesToCycle())
+        {
+            const auto oldSize = size();
+            if (tables.acquire())
+            {
+                // a stretched table is read at whatever is left between it and the period asked for
+                if (tableStretch != 1.0)
+                    tableStretch = (double)size() / (double)requested.maxWaveTimeSample;
+
+                const auto position = ((double)currentSample + tableFraction) * (double)size() / (double)oldSize;
+                currentSample = juce::jmin((size_t)position, size() - 1);
+                tableFraction = isModulated() ? position - (double)currentSample : 0.0;
+            }
+
+            restartPending = false;
+        }
+        else if (restartPending && tables.acquire() && tables.getReadBuffer().seedGeneration == seedGeneration)
+        {
+            // the seed's first table, so the cycle starts over on it and the next variation is asked for
+            restartPending = false;
+            currentSample  = 0;
+            cycleDrift     = 0.0;
+            drawVariation();
+            updateRequest();
+        }
 
-        updateMaxWaveTime();
-        updateWaveArraySize();
-        updateMidWaveTime();
+        bandLimitedTables.acquire();
+
+        if (! requestNeedsSending)
+            return false;
+
+        requests.getWriteBuffer() = requested;
+        requests.publish();
+        requestNeedsSending = false;
+        return true;
+    }
+
+    Type getNext() noexcept
+    {
+        Type output = get(currentSample % size());
+
+        if (++currentSample >= size())
+        {
+            currentSample = getCycleStart();
+            startNextCycle();
+        }
+
+        return output;
+    }
+
+    // restarts the wave from the beginning of its cycle
+    void reset() noexcept
+    {
+        currentSample  = 0;
+        phase          = 0.0;
+        cycleDrift     = 0.0;
+        syncedPosition = -1;
+        startNextCycle();
+    }
+
+    /** Moves the read position on without touching any audio, so the phase stays
+        where it would have been had the block been processed. */
+    void advance(int numSamples) noexcept
+    {
+        countSyncedSamples(numSamples);
+
+        if (requested.bandLimited)
+        {
+            phase = std::fmod(phase + numSamples * getIncrement(), 1.0);
+            advanceDepthScale(numSamples);
+        }
+        else if (isModulated())
+        {
+            advanceDepthScale(numSamples);
+            moveTablePosition(numSamples);
+        }
+        else if (! holdsTablesToCycle())
+        {
+            currentSample += (size_t)numSamples;
+            while (currentSample >= size())
+                currentSample = currentSample - size() + getCycleStart();
+        }
+        else
+        {
+            // cycle by cycle, so the variations are drawn just as they would be while processing
+            while (numSamples > 0)
+            {
+                auto runLength = (int)std::min((size_t)numSamples, size() - currentSample);
+                numSamples    -= runLength;
+                currentSample += (size_t)runLength;
+
+                if (currentSample >= size())
+                {
+                    currentSample = getCycleStart();
+                    startNextCycle();
+                }
+            }
+        }
+    }
+
+    /** Lines the wave up with a clock shared by a sync group. While the clock carries on from where
+        this wave has got to the wave keeps its own phase, so a speed or morph change bends the cycle
+        instead of jumping it. After a jump in the clock, or when the wave hasn't been running, it
+        jumps to where a wave started at sample 0 would be after this many samples, so waves driven
+        by the same clock line up exactly. */
+    void setPosition(juce::int64 samplePosition) noexcept
+    {
+        if (samplePosition == syncedPosition)
+            return;
+
+        syncedPosition = samplePosition;
+
+        if (requested.bandLimited)
+        {
+            phase = std::fmod((double)samplePosition * getIncrement(), 1.0);
+        }
+        else if (exactPeriod > 0.0)
+        {
+            // from the exact period, so the group doesn't drift from the clock as the cycles add up
+            currentSample = std::min(size() - 1, (size_t)std::fmod((double)samplePosition, getCyclePeriod()));
+            cycleDrift    = 0.0;
+        }
+        else
+        {
+            currentSample = (size_t)(samplePosition % (juce::int64)size());
+        }
+    }
+
+    // true when the wave is flat at 0 dB and would leave the audio unchanged
+    bool isUnity() const noexcept
+    {
+        if (morphTarget != nullptr)
+            return requested.depth == Type(0) && morphTarget->requested.depth == Type(0);
+
+        return requested.depth == Type(0);
+    }
+
+    /** Crossfades this wave into another one, 0 is this wave and 1 is the target. Both have to
+        read band-limited tables, which stay as they are, so moving the amount never rebuilds a table.
+        Pass nullptr to stop morphing. */
+    void setMorph(const Waves* target, Type amount) noexcept
+    {
+        jassert(target == nullptr || (requested.bandLimited && target->requested.bandLimited));
+        morphTarget = target;
+        morphAmount = juce::jlimit(Type(0), Type(1), amount);
+    }
+
+    /** Scales the depth and speed of the wave without touching its tables. The depth moves to the new
+        scale in a straight ramp over the next rampSamples, the speed changes straight away. For modulation
+        from an LFO read every few samples. Whole-sample tables are read between their samples while the
+        speed is scaled, which costs more than the straight multiply they get otherwise. */
+    void setModulation(Type newDepthScale, double newSpeedScale, int rampSamples) noexcept
+    {
+        // the dip can't go past silence, whatever the dial depth
+        const auto largestScale = std::abs(baseDepth) > Type(0) ? Type(0.999) / std::abs(baseDepth) : Type(1);
+        const auto target = juce::jlimit(Type(0), largestScale, newDepthScale);
+
+        depthRampRemaining = target != depthScale ? juce::jmax(1, rampSamples) : 0;
+        depthScaleStep     = depthRampRemaining > 0 ? (target - depthScale) / (Type)depthRampRemaining : Type(0);
+        speedScale         = newSpeedScale;
+    }
+
+    // Back to the dial depth and speed
+    void clearModulation() noexcept
+    {
+        depthScale         = Type(1);
+        depthScaleStep     = Type(0);
+        depthRampRemaining = 0;
+        speedScale         = 1.0;
+
+        if (tableStretch == 1.0)
+            tableFraction = 0.0;
+    }
+
+    /** Reads the table playing stretched to the period set last, so a new speed takes effect from this
+        sample rather than once the builder has the table for it, which can be a block or more later.
+        The stretch ends when that table is swapped in. Band-limited waves already follow the speed at
+        once, and randomised ones change speed at the start of each cycle, so they aren't stretched. */
+    void stretchToPeriod() noexcept
+    {
+        if (requested.bandLimited || holdsTablesToCycle())
+            return;
+
+        tableStretch = (double)size() / (double)requested.maxWaveTimeSample;
+    }
+
+    /** Multiplies a block of samples by the wave, advancing the read position.
+        The table is consumed in contiguous runs so each run is a single vector multiply.
+        If curve isn't nullptr the gains multiplied by are written there too. If amounts isn't nullptr
+        the dip of each gain is scaled by the amount for its sample first, 1 + amount * (gain - 1). */
+    void process(Type* data, int numSamples, Type* curve = nullptr, const Type* amounts = nullptr) noexcept
+    {
+        countSyncedSamples(numSamples);
+
+        if (requested.bandLimited)
+        {
+            processBandLimited(data, numSamples, curve, amounts);
+            return;
+        }
+
+        currentSample %= size();
+
+        if (isModulated())
+        {
+            while (numSamples > 0)
+            {
+                const auto runLength = getModulatedRunLength(numSamples);
+                readTableGains(gains.data(), runLength, 0.0);
+                applyDepthScale(gains.data(), runLength);
+                advanceDepthScale(runLength);
+                moveTablePosition(runLength);
+
+                applyGains(data, gains.data(), runLength, curve, amounts);
+                data       += runLength;
+                curve      += curve != nullptr ? runLength : 0;
+                amounts    += amounts != nullptr ? runLength : 0;
+                numSamples -= runLength;
+            }
+
+            return;
+        }
+
+        while (numSamples > 0)
+        {
+            const auto& table = tables.getReadBuffer();
+            auto runLength = (int)std::min((size_t)numSamples, size() - currentSample);
+            multiplyRun(data, table, currentSample, runLength, curve, amounts);
+
+            data          += runLength;
+            curve         += curve != nullptr ? runLength : 0;
+            amounts       += amounts != nullptr ? runLength : 0;
+            numSamples    -= runLength;
+            currentSample += (size_t)runLength;
+
+            if (currentSample >= size())
+            {
+                currentSample = getCycleStart();
+                startNextCycle();
+            }
+        }
+    }
+
+    /** Multiplies two channels by the same wave, the second read the offset (in cycles) further on.
+        Both come from this wave's one table through two read positions, so only one table is built
+        for the pair and the offset between them is exact whatever restarts the wave.
+        If the curves aren't nullptr the gains for each channel are written there too, and the amounts
+        scale the dips of both channels the same way as process(). */
+    void processStereo(Type* left, Type* right, int numSamples, double offset,
+                       Type* leftCurve = nullptr, Type* rightCurve = nullptr, const Type* amounts = nullptr) noexcept
+    {
+        jassert(offset >= 0.0 && offset <= 1.0);
+        jassert((leftCurve == nullptr) == (rightCurve == nullptr));
+        countSyncedSamples(numSamples);
+
+        if (requested.bandLimited)
+        {
+            if (! bandLimitedTablesReady())
+            {
+                fillUnity(leftCurve, numSamples);
+                fillUnity(rightCurve, numSamples);
+                return;
+            }
+
+            const auto increment = getIncrement();
+            auto offsetPhase = std::fmod(phase + offset, 1.0);
+
+            while (numSamples > 0)
+            {
+                auto runLength = juce::jmin(numSamples, (int)gains.size());
+
+                readGains(gains.data(), runLength, phase, increment);
+                applyDepthScale(gains.data(), runLength);
+                applyGains(left, gains.data(), runLength, leftCurve, amounts);
+
+                readGains(gains.data(), runLength, offsetPhase, increment);
+                applyDepthScale(gains.data(), runLength);
+                applyGains(right, gains.data(), runLength, rightCurve, amounts);
+                advanceDepthScale(runLength);
+
+                left       += runLength;
+                right      += runLength;
+                amounts    += amounts != nullptr ? runLength : 0;
+                numSamples -= runLength;
+
+                if (leftCurve != nullptr)
+                {
+                    leftCurve  += runLength;
+                    rightCurve += runLength;
+                }
+            }
+
+            return;
+        }
+
+        currentSample %= size();
+
+        if (isModulated())
+        {
+            while (numSamples > 0)
+            {
+                const auto runLength = getModulatedRunLength(numSamples);
+
+                readTableGains(gains.data(), runLength, 0.0);
+                applyDepthScale(gains.data(), runLength);
+                applyGains(left, gains.data(), runLength, leftCurve, amounts);
+
+                readTableGains(gains.data(), runLength, offset);
+                applyDepthScale(gains.data(), runLength);
+                applyGains(right, gains.data(), runLength, rightCurve, amounts);
+
+                advanceDepthScale(runLength);
+                moveTablePosition(runLength);
+
+                left       += runLength;
+                right      += runLength;
+                amounts    += amounts != nullptr ? runLength : 0;
+                numSamples -= runLength;
+
+                if (leftCurve != nullptr)
+                {
+                    leftCurve  += runLength;
+                    rightCurve += runLength;
+                }
+            }
+
+            return;
+        }
+
+        while (numSamples > 0)
+        {
+            // worked out again every run, as a randomised wave can change size at the end of a cycle
+            const auto& table = tables.getReadBuffer();
+            const auto offsetSample = (currentSample + (size_t)(offset * size())) % size();
+            auto runLength = (int)std::min({ (size_t)numSamples, size() - currentSample, size() - offsetSample });
+
+            multiplyRun(left,  table, currentSample, runLength, leftCurve,  amounts);
+            multiplyRun(right, table, offsetSample,  runLength, rightCurve, amounts);
+
+            left          += runLength;
+            right         += runLength;
+            amounts       += amounts != nullptr ? runLength : 0;
+            numSamples    -= runLength;
+            currentSample += (size_t)runLength;
+
+            if (leftCurve != nullptr)
+            {
+                leftCurve  += runLength;
+                rightCurve += runLength;
+            }
+
+            if (currentSample >= size())
+            {
+                currentSample = getCycleStart();
+                startNextCycle();
+            }
+        }
+    }
+
+    // the length of the cycle in samples
+    size_t size() const noexcept
+    {
+        return tables.getReadBuffer().length;
+    }
+
+    // returns a volume
+    Type get(size_t waveSample) const noexcept
+    {
+        jassert(waveSample >= 0 && waveSample < size());
+        const auto& table = tables.getReadBuffer();
+        const auto ramp   = getRamp(table, waveSample % size());
+        return ramp.start + ramp.step * (Type)ramp.offset;
+    }
+
+    //==============================================================================================
+    // table builder thread
+
+    /** Renders the newest request, if there is one, and publishes the table for the audio thread.
+        Tables that are in the cache are read from it instead of being rendered.
+        Returns false if there was nothing new to build. */
+    bool buildTable(const CustomShape& customShape, TableCache* cache = nullptr)
+    {
+        if (! requests.acquire())
+            return false;
+
+        const auto& request = requests.getReadBuffer();
+        depth             = request.depth;
+        maxWaveTimeSample = request.maxWaveTimeSample;
+        midWaveTimeSample = request.midWaveTimeSample;
+        controlInterval   = request.controlInterval;
+
+        const auto key = getCacheKey(request);
+        auto& table    = tables.getWriteBuffer();
+        table.interval = controlInterval;
+        table.length   = (size_t)maxWaveTimeSample;
+        table.peak     = (size_t)midWaveTimeSample;
+        table.seedGeneration = request.seedGeneration;
+        table.compact  = false;
+        table.mapped   = {}; // lets go of the file this buffer last played from, here rather than on the audio thread
+
+        // at control rate the longest table needs a point every interval, not every sample.
+        // Compact tables are rendered into values and then packed, so only the codes are kept
+        auto& values = table.values;
+        const auto capacity = (size_t)(request.tableCapacity / controlInterval + 2);
+        if (request.compact)
+            table.codes.reserve(capacity);
+        else
+            values.reserve(capacity);
+
+        builtRequest = request;
+
+        if (! request.customShape && cache != nullptr)
+        {
+            auto mapped = cache->load<Type>(key);
+            if (mapped && isValidTable(mapped.values, mapped.numPoints, depth))
+                table.mapped = std::move(mapped);
+        }
+
+        if (table.mapped)
+        {
+            values.clear(); // keeps its capacity for the next table that is rendered
+        }
+        else
+        {
+            values.resize((size_t)key.getNumPoints());
+
+            if (request.customShape)
+                customFunction(customShape);
+            else
+                updateFunctions(request.firstFunction, request.secondFunction);
+        }
+
+        jassert(isValidTable(table.getValues(), table.getNumPoints(), depth)); // a generator has gone out of range
+
+        if (request.bandLimited)
+        {
+            buildBandLimitedTables();
+            bandLimitedTables.publish();
+        }
+
+        {
+            const juce::SpinLock::ScopedLockType lock(displayLock);
+            displayTable.assign(table.getValues(), table.getValues() + table.getNumPoints());
+        }
+
+        if (request.compact)
+            compactTable(table);
+        else
+            std::vector<juce::uint16>().swap(table.codes);
+
+        tables.publish();
+        return true;
+    }
+
+    /** True if every value is finite and between the floor and unity, which every shape keeps to.
+        Catches a generator going wrong in debug builds and a damaged table read from the cache. */
+    static bool isValidTable(const Type* table, size_t numPoints, Type tableDepth) noexcept
+    {
+        const auto tolerance = Type(1.0e-4);
+        const auto floor     = Type(1) - std::abs(tableDepth) - tolerance;
+
+        return std::all_of(table, table + numPoints, [=](Type value)
+        {
+            return std::isfinite(value) && value >= floor && value <= Type(1) + tolerance;
+        });
+    }
+
+    // Writes the last table built to the cache, drawn shapes are left out as they are different in every session
+    void storeTable(TableCache& cache)
+    {
+        if (builtRequest.customShape || builtRequest.maxWaveTimeSample < 2)
+            return;
+
+        std::vector<Type> table;
+        {
+            const juce::SpinLock::ScopedLockType lock(displayLock);
+            table = displayTable;
+        }
+
+        const auto key = getCacheKey(builtRequest);
+        if (table.size() == (size_t)key.getNumPoints())
+            cache.store(key, table);
+    }
+
+    /** Set the specified sample in the table being built. At control rate there is only a point every
+        interval samples from the start of each half, so the peak always has one. */
+    void set(size_t waveSample, Type newValue) noexcept
+    {
+        auto& waveArray = tables.getWriteBuffer().values;
+        const auto interval = (size_t)controlInterval;
+        const auto peak     = (size_t)midWaveTimeSample;
+
+        jassert((waveSample < peak ? waveSample : waveSample - peak) % interval == 0);
+        const auto point = waveSample < peak ? waveSample / interval
+                                             : (peak + interval - 1) / interval + (waveSample - peak) / interval;
+        waveArray[point % waveArray.size()] = newValue;
+    }
+
+    //==============================================================================================
+    // message thread
+
+    // a copy of the last table built, for drawing
+    std::vector<Type> getDisplayTable() const
+    {
+        const juce::SpinLock::ScopedLockType lock(displayLock);
+        return displayTable;
+    }
+
+private:
+    // audio thread
+    size_t currentSample = 0;
+    double tableFraction = 0.0; // how far past currentSample the read position is, while the speed is modulated
+
+    // the period the speed asks for in samples, 0 when the cycles aren't meant to keep to it,
+    // and how far behind it the whole-sample cycles have fallen
+    double exactPeriod = 0.0;
+    double cycleDrift  = 0.0;
+
+    // where the sync group's clock is next if it runs on with this wave, -1 when it has to be found again
+    juce::int64 syncedPosition = -1;
+
+    // counts the reseedings, and whether a randomised wave is still waiting for the new seed's first table
+    int  seedGeneration = 0;
+    bool restartPending = false;
+
+    void countSyncedSamples(int numSamples) noexcept
+    {
+        if (syncedPosition >= 0)
+            syncedPosition += numSamples;
+    }
+
+    Type maxWaveTime{ 0 };
+    Type midWaveTime{ 0 };
+
+    // this is the only one that's channel independent
+    Type sampleRate{ Type(44.1e3) };
+    double inverseSampleRate = 1.0 / 44.1e3;
+    static constexpr double longestPeriod = 1.5; // in seconds, 60 bpm slowed by the largest random variation
+
+    // the dial depth, before any random variation
+    Type baseDepth{ 0 };
+
+    // at control rate the gain ramps between points of the table, the gap kept under this error
+    static constexpr double controlRateTolerance = 1.0e-3;
+    static constexpr int maxControlInterval = 64;
+    bool controlRate = false;
+    bool compactStorage = false;
+
+    // per-cycle variation, each value between -1 and 1 and scaled by the amount
+    struct Variation { float depth = 0.0f, peakTime = 0.0f, speed = 0.0f; };
+    RandomStream random;
+    Variation variation;
+    Type randomAmount{ 0 };
+
+    TableRequest requested;
+    bool requestNeedsSending = true;
+
+    // position and speed when reading the band-limited tables, in cycles
+    double phase = 0.0;
+    double phaseIncrement = 0.0;
+    std::array<Type, 256> gains{};
+
+    // modulation of the depth and speed, without rebuilding the tables
+    Type depthScale{ 1 }, depthScaleStep{ 0 };
+    int depthRampRemaining = 0;
+    double speedScale = 1.0;
+    double tableStretch = 1.0; // the table playing is read this much faster until the one for the new speed is in
+
+    // the wave being morphed into, and how far
+    const Waves* morphTarget = nullptr;
+    Type morphAmount{ 0 };
+    std::array<Type, 256> morphGains{};
+
+    // shared between the audio thread and the table builder
+    TripleBuffer<TableRequest> requests;
+    /** A table as the audio thread reads it. At control rate each half of the cycle has a point every
+        interval samples from its start, and the last gap of each half can be shorter. */
+    struct Table
+    {
+        std::vector<Type> values;
+        int interval = 1;
+        size_t length = 1; // the cycle, in samples
+        size_t peak = 0;   // where the second half starts
+        int seedGeneration = 0; // from the request, so a reseeded wave knows when its first table is in
+
+        // compact tables keep codes instead of values, each point is codeOffset + codeScale * code
+        bool compact = false;
+        std::vector<juce::uint16> codes;
+        Type codeOffset{ 0 }, codeScale{ 0 };
+
+        // a table from the cache is read where it is mapped, and the values are left empty
+        TableCache::MappedTable<Type> mapped;
+
+        const Type* getValues() const noexcept { return mapped ? mapped.values : values.data(); }
+
+        size_t getNumPoints() const noexcept
+        {
+            return compact ? codes.size() : (mapped ? mapped.numPoints : values.size());
+        }
+
+        Type getPoint(size_t point) const noexcept
+        {
+            return compact ? codeOffset + codeScale * (Type)codes[point] : getValues()[point];
+        }
+    };
+
+    static constexpr Type compactTolerance = Type(1.0e-5); // half a step of the codes at full depth is 7.6e-6
+    static constexpr int  decodeChunkSize  = 256;
+
+    TripleBuffer<Table> tables;
+    TripleBuffer<std::vector<Type>> bandLimitedTables; // every level, one after the other with a guard point each
+
+    // table builder thread
+    // End time
+    int maxWaveTimeSample = 2;
+
+    // Mid time
+    int midWaveTimeSample = 1;
+
+    // samples between the points being rendered
+    int controlInterval = 1;
+
+    Type depth{ 0 };
+
+    TableRequest builtRequest; // the request behind the last table built, for the cache
+
+    std::unique_ptr<juce::dsp::FFT> fft;
+    std::vector<float> spectrum, levelData;
+
+    // written by the table builder, read for drawing
+    mutable juce::SpinLock displayLock;
+    std::vector<Type> displayTable;
+
+    static TableCache::Key getCacheKey(const TableRequest& request) noexcept
+    {
+        TableCache::Key key;
+        key.firstFunction     = request.firstFunction;
+        key.secondFunction    = request.secondFunction;
+        key.depth             = (double)request.depth;
+        key.maxWaveTimeSample = request.maxWaveTimeSample;
+        key.midWaveTimeSample = request.midWaveTimeSample;
+        key.controlInterval   = request.controlInterval;
+        key.sampleSize        = (int)sizeof(Type);
+        return key;
+    }
+
+    bool holdsTablesToCycle() const noexcept
+    {
+        return randomAmount > Type(0) && ! requested.bandLimited;
+    }
+
+    void drawVariation() noexcept
+    {
+        variation.depth    = random.nextBipolar();
+        variation.peakTime = random.nextBipolar();
+        variation.speed    = random.nextBipolar();
+    }
+
+    /** Where the next cycle starts in the table, called as each cycle ends. A table is a whole number of
+        samples, up to one more than the period, so over hours of cycles a wave would fall behind the speed
+        it was set to. The shortfall is kept and whenever it reaches a sample the next cycle starts one
+        sample in, so the wave stays within a sample of the exact period. Periods within a thousandth of a
+        sample over a whole number are taken as that number, so a speed that is whole samples isn't skipping. */
+    size_t getCycleStart() noexcept
+    {
+        if (exactPeriod <= 0.0 || size() < 2)
+            return 0;
+
+        cycleDrift += (double)size() - getCyclePeriod();
+        if (cycleDrift < 1.0)
+            return 0;
+
+        cycleDrift -= 1.0;
+        return 1;
+    }
+
+    // the exact period, kept within a sample of the table playing in case a new one is still being built
+    double getCyclePeriod() const noexcept
+    {
+        const auto length = (double)size();
+        return juce::jlimit(length - 1.0, length, exactPeriod);
+    }
+
+    // At the start of every cycle, swaps in the table built for it and asks for the one after.
+    // After reseeding the old seed's table plays on until updateTable() has the new seed's first one
+    void startNextCycle() noexcept
+    {
+        if (! holdsTablesToCycle() || restartPending)
+            return;
+
+        tables.acquire();
+        drawVariation();
+        updateRequest();
+    }
+
+    // The request from the dials, with the variation for the next cycle when randomising
+    void updateRequest() noexcept
+    {
+        auto request      = requested;
+        auto periodTime   = maxWaveTime;
+        auto peakFraction = midWaveTime / maxWaveTime;
+        request.depth     = baseDepth;
+
+        if (holdsTablesToCycle())
+        {
+            // up to half the depth either way, a fifth of the cycle for the peak and half an octave of speed
+            request.depth = juce::jlimit(Type(-0.999), Type(0.999), baseDepth * (Type(1) + Type(0.5) * randomAmount * variation.depth));
+            peakFraction  = juce::jlimit(Type(0.2), Type(0.8), peakFraction + Type(0.2) * randomAmount * variation.peakTime);
+            periodTime   *= std::pow(Type(2), Type(0.5) * randomAmount * variation.speed);
+        }
+
+        // band-limited tables hold one cycle whatever the speed, so changing speed doesn't rebuild them.
+        // Other tables are rounded up to whole samples, and getCycleStart() takes the extra back out
+        const auto periodSamples  = (double)periodTime * (double)sampleRate;
+        request.maxWaveTimeSample = request.bandLimited ? bandLimitedTableSize
+                                                        : juce::jmax(2, (int)std::ceil(periodSamples - 1.0e-3));
+        exactPeriod = request.bandLimited || holdsTablesToCycle() ? 0.0 : periodSamples;
+
+        request.controlInterval = controlRate && ! request.bandLimited && ! request.customShape
+                                ? getControlInterval(request.maxWaveTimeSample, request.depth) : 1;
+
+        request.midWaveTimeSample = juce::jlimit(1, request.maxWaveTimeSample - 1,
+                                                 juce::roundToInt(peakFraction * request.maxWaveTimeSample));
+
+        request.compact = compactStorage && ! request.bandLimited && request.controlInterval == 1;
+        request.seedGeneration = holdsTablesToCycle() ? seedGeneration : 0;
+        setRequest(request);
+    }
+
+    /** The widest gap between points whose straight ramps stay within the tolerance. The sharpest bend in
+        any of the shapes is the top of the Gaussian, about 200 * depth / period^2, and a ramp across a gap
+        of n samples misses a bend c by at most c * n^2 / 8. The last gap of the cycle carries on the slope
+        before it and can be out by a little more. Powers of two only, and 1 when it isn't worth it. */
+    static int getControlInterval(int periodSamples, Type tableDepth) noexcept
+    {
+        const auto curvature = 200.0 * std::abs((double)tableDepth) / ((double)periodSamples * periodSamples);
+        const auto widest    = curvature > 0.0 ? std::sqrt(8.0 * controlRateTolerance / curvature) : (double)maxControlInterval;
+
+        int interval = 1;
+        while (interval * 2 <= juce::jmin(widest, (double)maxControlInterval) && interval * 2 < periodSamples / 2)
+            interval *= 2;
+
+        return interval < 4 ? 1 : interval;
+    }
+
+    // Where a sample falls between two points of the table
+    struct Ramp
+    {
+        Type start, step;
+        size_t offset, remaining; // samples into the ramp, and left of it
+    };
+
+    static Ramp getRamp(const Table& table, size_t position) noexcept
+    {
+        // each half has its own points from its start, the last gap of a half ends with it
+        const auto interval   = (size_t)table.interval;
+        const bool secondHalf = position >= table.peak;
+        const auto halfStart  = secondHalf ? table.peak : 0;
+        const auto halfEnd    = secondHalf ? table.length : table.peak;
+        const auto firstPoint = secondHalf ? (table.peak + interval - 1) / interval : 0;
+
+        const auto point = firstPoint + (position - halfStart) / interval;
+        const auto start = halfStart + (point - firstPoint) * interval;
+        const auto end   = std::min(start + interval, halfEnd);
+
+        const auto value = table.getPoint(point);
+        auto step = (Type)0;
+
+        // the last gap carries on the slope before it rather than ramping into the start of the next
+        // cycle, so a shape that doesn't end where it starts keeps its step there just as it would per sample
+        if (point + 1 < table.getNumPoints())
+            step = (table.getPoint(point + 1) - value) / (Type)(end - start);
+        else if (point > firstPoint)
+            step = (value - table.getPoint(point - 1)) / (Type)interval;
+        else
+            step = (table.getPoint(0) - value) / (Type)(end - start);
+
+        return { value, step, position - start, end - position };
+    }
+
+    /** Multiplies a run of samples that ends within the cycle by the table from the position. At control
+        rate that is one linear gain ramp for every gap between points. */
+    static void multiplyRun(Type* data, const Table& table, size_t position, int runLength, Type* curve,
+                            const Type* amounts) noexcept
+    {
+        const bool plainMultiply = curve == nullptr && amounts == nullptr;
+
+        if (table.compact)
+        {
+            // decoded in the multiply, a convert and a multiply-add that the compiler vectorises
+            const auto* codes = table.codes.data() + position;
+            const auto offset = table.codeOffset, scale = table.codeScale;
+
+            if (plainMultiply)
+            {
+                for (int i = 0; i < runLength; i++)
+                    data[i] *= offset + scale * (Type)codes[i];
+                return;
+            }
+
+            // otherwise a chunk at a time on the stack so the curve is exactly what was multiplied by
+            Type decoded[decodeChunkSize];
+            while (runLength > 0)
+            {
+                const auto chunkLength = std::min(runLength, decodeChunkSize);
+                for (int i = 0; i < chunkLength; i++)
+                    decoded[i] = offset + scale * (Type)codes[i];
+
+                applyGains(data, decoded, chunkLength, curve, amounts);
+                data      += chunkLength;
+                curve     += curve != nullptr ? chunkLength : 0;
+                amounts   += amounts != nullptr ? chunkLength : 0;
+                codes     += chunkLength;
+                runLength -= chunkLength;
+            }
+            return;
+        }
+
+        if (table.interval == 1)
+        {
+            applyGains(data, table.getValues() + position, runLength, curve, amounts);
+            return;
+        }
+
+        Type ramped[decodeChunkSize];
+
+        while (runLength > 0)
+        {
+            const auto ramp = getRamp(table, position);
+            const auto rampLength = (int)std::min({ (size_t)runLength, ramp.remaining, (size_t)decodeChunkSize });
+            const auto gain = ramp.start + ramp.step * (Type)ramp.offset;
+
+            if (plainMultiply)
+            {
+                for (int i = 0; i < rampLength; i++)
+                    data[i] *= gain + ramp.step * (Type)i;
+            }
+            else
+            {
+                for (int i = 0; i < rampLength; i++)
+                    ramped[i] = gain + ramp.step * (Type)i;
+
+                applyGains(data, ramped, rampLength, curve, amounts);
+                curve   += curve != nullptr ? rampLength : 0;
+                amounts += amounts != nullptr ? rampLength : 0;
+            }
+
+            data      += rampLength;
+            runLength -= rampLength;
+            position  += (size_t)rampLength;
+        }
+    }
+
+    /** Packs the values into 16 bit codes spread over the table's own range and lets the values go,
+        so the table holds half the memory. Runs on the builder thread, where the allocation is fine. */
+    static void compactTable(Table& table)
+    {
+        const auto* values   = table.getValues();
+        const auto numPoints = table.getNumPoints();
+        const auto range     = std::minmax_element(values, values + numPoints);
+
+        table.codeOffset = *range.first;
+        table.codeScale  = (*range.second - *range.first) / Type(65535);
+
+        const auto inverseScale = table.codeScale > Type(0) ? Type(1) / table.codeScale : Type(0);
+        table.codes.resize(numPoints);
+        for (size_t i = 0; i < numPoints; i++)
+            table.codes[i] = (juce::uint16)juce::roundToInt((values[i] - table.codeOffset) * inverseScale);
+
+        jassert(table.codeScale * Type(0.5) <= compactTolerance);
+        table.compact = true;
+        table.mapped  = {};
+        std::vector<Type>().swap(table.values);
+    }
+
+    // The multiply itself, the gains are copied out first when the curve is wanted and then multiplied from there
+    static void applyGains(Type* data, const Type* gainValues, int numSamples, Type* curve, const Type* amounts) noexcept
+    {
+        if (amounts == nullptr)
+        {
+            if (curve == nullptr)
+            {
+                juce::FloatVectorOperations::multiply(data, gainValues, numSamples);
+                return;
+            }
+
+            juce::FloatVectorOperations::copy(curve, gainValues, numSamples);
+            juce::FloatVectorOperations::multiply(data, curve, numSamples);
+            return;
+        }
+
+        // 1 + amount * (gain - 1), scaled into the curve when there is one and a chunk on the stack when not
+        Type scaled[decodeChunkSize];
+        while (numSamples > 0)
+        {
+            const auto chunkLength = std::min(numSamples, decodeChunkSize);
+            auto* dipGains = curve != nullptr ? curve : scaled;
+
+            juce::FloatVectorOperations::add(dipGains, gainValues, Type(-1), chunkLength);
+            juce::FloatVectorOperations::multiply(dipGains, amounts, chunkLength);
+            juce::FloatVectorOperations::add(dipGains, Type(1), chunkLength);
+            juce::FloatVectorOperations::multiply(data, dipGains, chunkLength);
+
+            data       += chunkLength;
+            gainValues += chunkLength;
+            amounts    += chunkLength;
+            curve      += curve != nullptr ? chunkLength : 0;
+            numSamples -= chunkLength;
+        }
+    }
+
+    static void fillUnity(Type* curve, int numSamples) noexcept
+    {
+        if (curve != nullptr)
+            juce::FloatVectorOperations::fill(curve, Type(1), numSamples);
+    }
+
+    void setRequest(const TableRequest& request) noexcept
+    {
+        if (request != requested)
+        {
+            requested = request;
+            requestNeedsSending = true;
+        }
     }
 
     void updateFunctions(int first, int second)
     {
+        WAVES_TRACE_SCOPE("Waves::updateFunctions");
+
+        // renders the table being built
         // 1 for linear
         // 2 for sine
         // 3 for Gaussian
@@ -101,111 +1185,265 @@ public:
         }
     }
 
-    Type getNext() noexcept
+    void processBandLimited(Type* data, int numSamples, Type* curve, const Type* amounts) noexcept
     {
-        Type output = waveArray[currentSample % size()];
-        currentSample = (currentSample + 1) % size();
-        return output;
+        if (! bandLimitedTablesReady())
+        {
+            fillUnity(curve, numSamples); // not built yet, so leave the audio as it is
+            return;
+        }
+
+        const auto increment = getIncrement();
+
+        while (numSamples > 0)
+        {
+            auto runLength = juce::jmin(numSamples, (int)gains.size());
+            readGains(gains.data(), runLength, phase, increment);
+            applyDepthScale(gains.data(), runLength);
+            advanceDepthScale(runLength);
+
+            applyGains(data, gains.data(), runLength, curve, amounts);
+            data       += runLength;
+            curve      += curve != nullptr ? runLength : 0;
+            amounts    += amounts != nullptr ? runLength : 0;
+            numSamples -= runLength;
+        }
     }
 
-    std::vector<Type>& getWaveArray()
+    bool bandLimitedTablesReady() const noexcept
     {
-        return waveArray;
+        return ! bandLimitedTables.getReadBuffer().empty()
+            && (morphTarget == nullptr || ! morphTarget->bandLimitedTables.getReadBuffer().empty());
     }
 
-    /** Set the specified sample in the delay line */
-    void set(size_t waveSample, Type newValue) noexcept
+    /** Reads up to 256 gains from the phase on. When morphing the target is read at the same phase
+        and the speed moves between theirs with the amount. */
+    void readGains(Type* output, int numSamples, double& readPhase, double increment) noexcept
     {
-        //jassert(waveSample >= 0 && waveSample < size());
-        waveArray[(waveSample) % size()] = newValue;
+        if (morphTarget == nullptr)
+        {
+            readBandLimited(output, numSamples, readPhase, increment);
+            return;
+        }
+
+        auto targetPhase = readPhase;
+        readBandLimited(output, numSamples, readPhase, increment);
+        morphTarget->readBandLimited(morphGains.data(), numSamples, targetPhase, increment);
+
+        // this wave + amount * (target - this wave), all as vector operations
+        juce::FloatVectorOperations::multiply(output, Type(1) - morphAmount, numSamples);
+        juce::FloatVectorOperations::addWithMultiply(output, morphGains.data(), morphAmount, numSamples);
     }
 
+    // the phase increment per sample, between this wave's and the morph target's when morphing
+    double getIncrement() const noexcept
+    {
+        const auto increment = phaseIncrement * speedScale;
+        if (morphTarget == nullptr)
+            return increment;
 
-    size_t size() const noexcept
+        return increment + (double)morphAmount * (morphTarget->phaseIncrement * morphTarget->speedScale - increment);
+    }
+
+    bool isModulated() const noexcept
     {
-        return waveArray.size();
+        return getTableSpeed() != 1.0 || depthScale != Type(1) || depthRampRemaining > 0;
     }
 
-    void resize(size_t newValue)
+    // samples of the table read for every sample played
+    double getTableSpeed() const noexcept
     {
-        if (newValue == 0)
-        {
-            newValue = 1;
-        }
-        waveArray.resize(newValue);
+        return speedScale * tableStretch;
     }
 
-    Type get(size_t waveSample) const noexcept
+    // up to a buffer of gains, ending at the end of the cycle so a new cycle's table is read from its start
+    int getModulatedRunLength(int numSamples) const noexcept
     {
-        jassert(waveSample >= 0 && waveSample < size());
-        return waveArray[(waveSample) % size()];
+        const auto toCycleEnd = ((double)size() - (double)currentSample - tableFraction) / getTableSpeed();
+        return juce::jlimit(1, juce::jmin(numSamples, (int)gains.size()), (int)std::ceil(toCycleEnd));
     }
 
-private:
-    size_t currentSample = 0;    
+    /** Reads a run of whole-sample gains at the modulated speed, between the samples of the table, from
+        the read position and the offset (in cycles) further on. The position isn't moved on. */
+    void readTableGains(Type* output, int numSamples, double offset) const noexcept
+    {
+        const auto& table  = tables.getReadBuffer();
+        const auto length  = (double)table.length;
+        auto position      = std::fmod((double)currentSample + tableFraction + offset * length, length);
+        const auto speed   = getTableSpeed();
 
-    std::vector<Type> waveArray;
+        for (int i = 0; i < numSamples; i++)
+        {
+            const auto index    = (size_t)position;
+            const auto fraction = (Type)(position - (double)index);
+            const auto now      = getRamp(table, index);
+            const auto next     = getRamp(table, index + 1 < table.length ? index + 1 : 0);
+            const auto gain     = now.start + now.step * (Type)now.offset;
 
-    // End time 
-    int   maxWaveTimeSample;
-    float maxWaveTime;
+            output[i] = gain + fraction * (next.start + next.step * (Type)next.offset - gain);
 
-    // Mid time
-    int   midWaveTimeSample;
-    float midWaveTime;
+            position += speed;
+            if (position >= length)
+                position -= length;
+        }
+    }
 
-    float depth;
+    // moves the whole-sample read position on at the modulated speed, starting each new cycle as it comes
+    void moveTablePosition(int numSamples) noexcept
+    {
+        auto distance = numSamples * getTableSpeed();
 
-    // this is the only one that's channel independent
-    float sampleRate{ float(44.1e3) };
+        for (;;)
+        {
+            const auto position = (double)currentSample + tableFraction + distance;
+            if (position < (double)size())
+            {
+                currentSample = (size_t)position;
+                tableFraction = position - (double)currentSample;
+                return;
+            }
 
+            distance      = position - (double)size();
+            currentSample = getCycleStart();
+            tableFraction = 0.0;
+            startNextCycle();
+        }
+    }
 
-    void clear() noexcept
+    /** Scales the dip of a run of gains by the modulated depth. Every shape's dip below unity is in
+        proportion to its depth, so this is the same as a table built at the scaled depth. */
+    void applyDepthScale(Type* values, int numSamples) const noexcept
     {
-        std::fill(waveArray.begin(), waveArray.end(), Type(0.0));
+        if (depthScale == Type(1) && depthRampRemaining == 0)
+            return;
+
+        auto scale = depthScale;
+        const auto rampLength = juce::jmin(numSamples, depthRampRemaining);
+
+        for (int i = 0; i < numSamples; i++)
+        {
+            values[i] = Type(1) - scale * (Type(1) - values[i]);
+            if (i < rampLength)
+                scale += depthScaleStep;
+        }
     }
 
+    void advanceDepthScale(int numSamples) noexcept
+    {
+        const auto steps = juce::jmin(numSamples, depthRampRemaining);
+        depthScale         += depthScaleStep * (Type)steps;
+        depthRampRemaining -= steps;
+    }
 
-    void updateWaveArraySize() // TODO: fix
+    /** Reads the band-limited cycle at the given phase into output, moving the phase on by the increment
+        every sample. The increment also picks the levels, so the wave doesn't alias at audio rate. */
+    void readBandLimited(Type* output, int numSamples, double& readPhase, double increment) const noexcept
     {
-        auto waveArraySizeSamples = (int)std::ceil(maxWaveTime * sampleRate);
-        waveArray.resize(waveArraySizeSamples);
+        const auto& levels = bandLimitedTables.getReadBuffer();
+
+        // Level n keeps 1024 >> n harmonics. Take the two levels either side of half the harmonics
+        // that fit below Nyquist and crossfade, so neither aliases and nothing jumps as the speed moves
+        auto harmonicsBelowNyquist = 0.5 / increment;
+        auto position = juce::jlimit(0.0, numBandLimitedLevels - 1.0,
+                                     numBandLimitedLevels - std::log2(juce::jmax(1.0, harmonicsBelowNyquist)));
+        auto level = juce::jmin((int)position, numBandLimitedLevels - 2);
+        auto fade  = (Type)(position - level);
+
+        const auto* richer  = levels.data() + (size_t)level * (bandLimitedTableSize + 1);
+        const auto* smoother = richer + bandLimitedTableSize + 1;
+
+        for (int i = 0; i < numSamples; i++)
+        {
+            auto index = readPhase * bandLimitedTableSize;
+            auto sample = (int)index;
+            auto frac = (Type)(index - sample);
+
+            auto a = richer[sample]   + frac * (richer[sample + 1]   - richer[sample]);
+            auto b = smoother[sample] + frac * (smoother[sample + 1] - smoother[sample]);
+            output[i] = a + fade * (b - a);
+
+            readPhase += increment;
+            if (readPhase >= 1.0)
+                readPhase -= 1.0;
+        }
     }
 
-    void updateMaxWaveTime() noexcept
+    // Makes every level from the cycle just rendered by removing harmonics in the frequency domain
+    void buildBandLimitedTables()
     {
-        maxWaveTimeSample = (int)juce::roundToInt(maxWaveTime * sampleRate);
+        if (fft == nullptr)
+        {
+            fft = std::make_unique<juce::dsp::FFT>(bandLimitedOrder);
+            spectrum.resize(2 * bandLimitedTableSize);
+            levelData.resize(2 * bandLimitedTableSize);
+        }
+
+        const auto* cycle = tables.getWriteBuffer().getValues();
+        std::fill(spectrum.begin(), spectrum.end(), 0.0f);
+        for (int i = 0; i < bandLimitedTableSize; i++)
+            spectrum[(size_t)i] = (float)cycle[(size_t)i];
+
+        fft->performRealOnlyForwardTransform(spectrum.data());
+
+        auto& levels = bandLimitedTables.getWriteBuffer();
+        levels.resize((size_t)numBandLimitedLevels * (bandLimitedTableSize + 1));
+
+        for (int level = 0; level < numBandLimitedLevels; level++)
+        {
+            // clear every bin above the harmonic limit, and its mirror image
+            auto harmonics = (bandLimitedTableSize / 2) >> level;
+            levelData = spectrum;
+            for (int bin = harmonics + 1; bin < bandLimitedTableSize - harmonics; bin++)
+                levelData[(size_t)(2 * bin)] = levelData[(size_t)(2 * bin + 1)] = 0.0f;
+
+            fft->performRealOnlyInverseTransform(levelData.data());
+
+            auto* destination = levels.data() + (size_t)level * (bandLimitedTableSize + 1);
+            for (int i = 0; i < bandLimitedTableSize; i++)
+                destination[i] = (Type)levelData[(size_t)i];
+            destination[bandLimitedTableSize] = destination[0]; // so reading between the last and first needs no wrap
+        }
     }
 
-    void updateMidWaveTime() noexcept
+    void customFunction(const CustomShape& shape)
     {
-        midWaveTimeSample = (size_t)juce::roundToInt(midWaveTime * sampleRate);
+        const auto peak = (double)midWaveTimeSample / maxWaveTimeSample;
+
+        for (int i = 0; i < maxWaveTimeSample; i += controlInterval)
+        {
+            // the shape is drawn with its peak in the middle, so stretch each half to follow the skew
+            auto x = (double)i / maxWaveTimeSample;
+            auto t = x < peak ? 0.5 * x / peak : 0.5 + 0.5 * (x - peak) / (1.0 - peak);
+
+            auto dip = Type(1) - (Type)shape.evaluate((float)t); // 0 for untouched, 1 for full depth
+            set(i, Type(1) + std::min(depth, Type(0)) - depth * dip);
+        }
     }
 
     void linearFirstFunction()
     {
         //float volIncrement = (volumeTwo - volumeOne) / midWaveTimeSample;
-        float volIncrement = -1.0f * depth / midWaveTimeSample; // temp v1 = depth
+        Type volIncrement = Type(-1) * depth / midWaveTimeSample; // temp v1 = depth
 
-        auto startVol = 1.0 + std::min(depth, 0.0f);
+        auto startVol = Type(1) + std::min(depth, Type(0));
 
 
-        for (int i = 0; i <= midWaveTimeSample; i++)
+        for (int i = 0; i <= midWaveTimeSample; i += controlInterval)
         {
-            float value = startVol + i * volIncrement;
+            Type value = startVol + i * volIncrement;
             set(i, value);
         }
     }
 
     void linearSecondFunction()
     {
-        float delta = depth / (maxWaveTimeSample - midWaveTimeSample);
+        Type delta = depth / (maxWaveTimeSample - midWaveTimeSample);
 
-        auto startVol = 1.0 - std::max(depth, 0.0f);
+        auto startVol = Type(1) - std::max(depth, Type(0));
 
-        for (int i = midWaveTimeSample; i < maxWaveTimeSample; i++)
+        for (int i = midWaveTimeSample; i < maxWaveTimeSample; i += controlInterval)
         {
-            float value = startVol + (i - midWaveTimeSample) * delta;
+            Type value = startVol + (i - midWaveTimeSample) * delta;
             set(i, value);
         }
     }
@@ -213,16 +1451,16 @@ private:
     void sineFirstFunction()
     {
         constexpr double pi = 3.14159265358979323846;
-        float cosArg;
-        float value;
-        auto floor = 1.0f - std::abs(depth);
+        Type cosArg;
+        Type value;
+        auto floor = Type(1) - std::abs(depth);
         
-        for (int i = 0; i < midWaveTimeSample; i++)
+        for (int i = 0; i < midWaveTimeSample; i += controlInterval)
         {
-            cosArg = i * pi / midWaveTimeSample;
+            cosArg = (Type)(i * pi / midWaveTimeSample);
             value = std::cos(cosArg); // between 0 and 1
             value *= sgn(depth); // multiply by -sgn(d)
-            value = (value + 1) / 2; // between 0 and 1
+            value = (value + Type(1)) / Type(2); // between 0 and 1
             value *= std::abs(depth); // between v1 and v2
             value += floor;
             set(i, value);
@@ -232,16 +1470,16 @@ private:
     void sineSecondFunction()
     {
         constexpr double pi = 3.14159265358979323846;
-        float cosArg;
-        float value;
-        auto floor = 1.0f - std::abs(depth);
+        Type cosArg;
+        Type value;
+        auto floor = Type(1) - std::abs(depth);
 
-        for (int i = midWaveTimeSample; i < maxWaveTimeSample; i++)
+        for (int i = midWaveTimeSample; i < maxWaveTimeSample; i += controlInterval)
         {
-            cosArg = (i - midWaveTimeSample) * 1.0f * pi / (maxWaveTimeSample - midWaveTimeSample);
-            value = std::cos(cosArg - pi); // between 0 and 1
+            cosArg = (Type)((i - midWaveTimeSample) * pi / (maxWaveTimeSample - midWaveTimeSample));
+            value = std::cos(cosArg - (Type)pi); // between 0 and 1
             value *= sgn(depth); // invert if v1 > v2
-            value = (value + 1) / 2; // between 0 and 1
+            value = (value + Type(1)) / Type(2); // between 0 and 1
             value *= std::abs(depth); // between v1 and v2
             value += floor;
             set(i, value);
@@ -252,20 +1490,24 @@ private:
     {
         // gaussian curve
         constexpr double invpi = 0.31830988618379067154;
-        auto value = 1.0f;
-        auto arg = 1.0f;
-        auto w = maxWaveTimeSample * 0.1;
-        auto floor = 1.0f - std::abs(depth);
+        auto value = Type(1);
+        auto arg = Type(1);
+        auto w = maxWaveTimeSample * Type(0.1);
+        auto floor = Type(1) - std::abs(depth);
+
+        // the curve never quite gets back to 1, so it is stretched to start there exactly,
+        // otherwise the cycle steps where it wraps round
+        const auto edge = std::exp(-(Type)midWaveTimeSample * (Type)midWaveTimeSample / (w * w));
 
-        for (int i = 0; i < midWaveTimeSample; i++)
+        for (int i = 0; i < midWaveTimeSample; i += controlInterval)
         {
-            arg = pow(i - midWaveTimeSample, 2);
-            arg = -1.0f * arg / pow(w, 2);
-            value = std::exp(arg);
+            arg = (Type)std::pow(i - midWaveTimeSample, 2);
+            arg = Type(-1) * arg / (w * w);
+            value = (std::exp(arg) - edge) / (Type(1) - edge);
 
-            value -= 0.5;
-            value *= -1.0f * sgn(depth);
-            value += 0.5;
+            value -= Type(0.5);
+            value *= Type(-1) * sgn(depth);
+            value += Type(0.5);
 
             value *= std::abs(depth);
             value += floor;
@@ -277,20 +1519,24 @@ private:
     void gaussSecondFunction()
     {
         constexpr double invpi = 0.31830988618379067154;
-        auto value = 1.0f;
-        auto arg = 1.0f;
-        auto w = maxWaveTimeSample * 0.1;
-        auto floor = 1.0f - std::abs(depth);
+        auto value = Type(1);
+        auto arg = Type(1);
+        auto w = maxWaveTimeSample * Type(0.1);
+        auto floor = Type(1) - std::abs(depth);
+
+        // stretched to end at 1 exactly, like the first half
+        const auto secondHalf = (Type)(maxWaveTimeSample - midWaveTimeSample);
+        const auto edge = std::exp(-secondHalf * secondHalf / (w * w));
 
-        for (int i = midWaveTimeSample; i < maxWaveTimeSample; i++)
+        for (int i = midWaveTimeSample; i < maxWaveTimeSample; i += controlInterval)
         {
-            arg = pow(i - midWaveTimeSample, 2);
-            arg = -1.0f * arg / pow(w, 2);
-            value = std::exp(arg);
+            arg = (Type)std::pow(i - midWaveTimeSample, 2);
+            arg = Type(-1) * arg / (w * w);
+            value = (std::exp(arg) - edge) / (Type(1) - edge);
 
-            value -= 0.5;
-            value *= -1.0f * sgn(depth); // invert if v1 > v2
-            value += 0.5;
+            value -= Type(0.5);
+            value *= Type(-1) * sgn(depth); // invert if v1 > v2
+            value += Type(0.5);
 
             value *= std::abs(depth); // between v1 and v2
             value += floor;
@@ -299,8 +1545,8 @@ private:
     }
 
     /* returns +1 for pos, -1 for neg, 0 for 0 */
-    int sgn(float x)
+    int sgn(Type x)
     {
-        return ((0.0f < x) - (x < 0.0f));
+        return ((Type(0) < x) - (x < Type(0)));
     }
 };
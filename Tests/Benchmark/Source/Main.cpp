@@ -0,0 +1,232 @@
+/*
+  ==============================================================================
+
+    Main.cpp
+    Created: 19 Oct 2026 10:07:33pm
+    Author:  James Muten
+    Times the gain pass over full and compact (16 bit) tables, for one
+    wave that fits in the caches and for enough long waves that it
+    doesn't, in both precisions. On Linux the last level cache misses
+    are counted too. Build the Release configuration to run it.
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include <iostream>
+#include "../../../Source/Waves.h"
+
+#if JUCE_LINUX
+ #include <linux/perf_event.h>
+ #include <sys/ioctl.h>
+ #include <sys/syscall.h>
+ #include <unistd.h>
+#endif
+
+namespace
+{
+    // counts the last level cache misses of this thread, where the kernel lets it
+    class CacheMissCounter
+    {
+    public:
+        CacheMissCounter()
+        {
+           #if JUCE_LINUX
+            perf_event_attr attributes{};
+            attributes.type           = PERF_TYPE_HARDWARE;
+            attributes.size           = sizeof(attributes);
+            attributes.config         = PERF_COUNT_HW_CACHE_MISSES;
+            attributes.disabled       = 1;
+            attributes.exclude_kernel = 1;
+            attributes.exclude_hv     = 1;
+            descriptor = (int)syscall(__NR_perf_event_open, &attributes, 0, -1, -1, 0);
+           #endif
+        }
+
+        ~CacheMissCounter()
+        {
+           #if JUCE_LINUX
+            if (descriptor >= 0)
+                close(descriptor);
+           #endif
+        }
+
+        bool isAvailable() const noexcept { return descriptor >= 0; }
+
+        void start() noexcept
+        {
+           #if JUCE_LINUX
+            if (descriptor >= 0)
+            {
+                ioctl(descriptor, PERF_EVENT_IOC_RESET, 0);
+                ioctl(descriptor, PERF_EVENT_IOC_ENABLE, 0);
+            }
+           #endif
+        }
+
+        juce::int64 stop() noexcept
+        {
+            juce::int64 count = 0;
+           #if JUCE_LINUX
+            if (descriptor >= 0)
+            {
+                ioctl(descriptor, PERF_EVENT_IOC_DISABLE, 0);
+                if (read(descriptor, &count, sizeof(count)) != (ssize_t)sizeof(count))
+                    count = 0;
+            }
+           #endif
+            return count;
+        }
+
+    private:
+        int descriptor = -1;
+
+        JUCE_DECLARE_NON_COPYABLE(CacheMissCounter)
+    };
+
+    struct Scenario
+    {
+        const char* name;
+        double sampleRate;
+        int numWaves;
+        int numBlocks;
+    };
+
+    // 60 bpm slowed by the largest random variation, the longest table the waves make
+    constexpr float cycleSeconds = 1.5f;
+    constexpr int blockSize = 512;
+
+    struct Result
+    {
+        double nanosecondsPerSample = 0.0;
+        double missesPerSample = -1.0; // when the counter isn't available
+        size_t tableBytes = 0;
+        double largestDifference = 0.0; // from the full tables, for the compact ones
+    };
+
+    template <typename Type>
+    std::vector<Waves<Type>> makeWaves(const Scenario& scenario, bool compact)
+    {
+        std::vector<Waves<Type>> waves((size_t)scenario.numWaves);
+        const CustomShape noCustomShape;
+
+        for (size_t i = 0; i < waves.size(); i++)
+        {
+            auto& wave = waves[i];
+            wave.prepare({ scenario.sampleRate, (juce::uint32)blockSize, 2 });
+            wave.setCompactStorage(compact);
+            wave.setParameters(Type(0.8), (Type)cycleSeconds, Type(0.4) * (Type)cycleSeconds);
+            wave.setFunctions(1 + (int)i % 3, 1 + (int)(i / 3) % 3);
+            wave.updateTable();
+            wave.buildTable(noCustomShape);
+            wave.updateTable();
+        }
+
+        return waves;
+    }
+
+    // every wave multiplies a block in turn, the way the instances in a session take their turns
+    template <typename Type>
+    Result run(const Scenario& scenario, bool compact, CacheMissCounter& counter)
+    {
+        auto waves = makeWaves<Type>(scenario, compact);
+        std::vector<Type> block((size_t)blockSize);
+
+        Result result;
+        result.tableBytes = waves.size() * (size_t)std::ceil(cycleSeconds * scenario.sampleRate) * (compact ? sizeof(juce::uint16) : sizeof(Type));
+
+        // one pass to warm up, then the timed ones
+        for (auto& wave : waves)
+        {
+            juce::FloatVectorOperations::fill(block.data(), Type(1), blockSize);
+            wave.process(block.data(), blockSize);
+        }
+
+        counter.start();
+        const auto start = juce::Time::getHighResolutionTicks();
+
+        for (int pass = 0; pass < scenario.numBlocks; pass++)
+        {
+            for (auto& wave : waves)
+            {
+                juce::FloatVectorOperations::fill(block.data(), Type(1), blockSize);
+                wave.process(block.data(), blockSize);
+            }
+        }
+
+        const auto seconds = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - start);
+        const auto misses  = counter.stop();
+
+        const auto numSamples = (double)scenario.numBlocks * (double)waves.size() * blockSize;
+        result.nanosecondsPerSample = seconds * 1.0e9 / numSamples;
+        if (counter.isAvailable())
+            result.missesPerSample = (double)misses / numSamples;
+
+        // the compact tables have to read the same shape as the full ones
+        if (compact)
+        {
+            auto fullWaves = makeWaves<Type>(scenario, false);
+            std::vector<Type> fullBlock((size_t)blockSize);
+
+            for (size_t i = 0; i < waves.size(); i++)
+            {
+                waves[i].reset();
+                for (int sample = 0; sample < (int)waves[i].size(); sample += blockSize)
+                {
+                    juce::FloatVectorOperations::fill(block.data(), Type(1), blockSize);
+                    juce::FloatVectorOperations::fill(fullBlock.data(), Type(1), blockSize);
+                    waves[i].process(block.data(), blockSize);
+                    fullWaves[i].process(fullBlock.data(), blockSize);
+
+                    for (int j = 0; j < blockSize; j++)
+                        result.largestDifference = juce::jmax(result.largestDifference, std::abs((double)block[(size_t)j] - (double)fullBlock[(size_t)j]));
+                }
+            }
+        }
+
+        return result;
+    }
+
+    void printResult(const Scenario& scenario, const char* type, bool compact, const Result& result)
+    {
+        std::cout << juce::String(scenario.name).paddedRight(' ', 30)
+                  << juce::String(type).paddedRight(' ', 8)
+                  << juce::String(compact ? "compact" : "full").paddedRight(' ', 9)
+                  << juce::String((double)result.tableBytes / 1024.0, 0).paddedLeft(' ', 10)
+                  << juce::String(result.nanosecondsPerSample, 3).paddedLeft(' ', 12)
+                  << (result.missesPerSample < 0.0 ? juce::String("n/a") : juce::String(result.missesPerSample, 4)).paddedLeft(' ', 15)
+                  << (compact ? juce::String(result.largestDifference, 7) : juce::String("-")).paddedLeft(' ', 13)
+                  << std::endl;
+    }
+}
+
+//==================================================================================================
+int main()
+{
+    const Scenario scenarios[] = {
+        { "1 wave at 48 kHz",   48000.0,  1, 200000 },
+        { "16 waves at 192 kHz", 192000.0, 16, 4000 },
+    };
+
+    CacheMissCounter counter;
+
+    std::cout << "Gain pass over full and compact tables, per sample of each wave" << std::endl
+              << juce::String("scenario").paddedRight(' ', 30) << juce::String("type").paddedRight(' ', 8)
+              << juce::String("storage").paddedRight(' ', 9) << juce::String("tables KB").paddedLeft(' ', 10)
+              << juce::String("ns/sample").paddedLeft(' ', 12) << juce::String("misses/sample").paddedLeft(' ', 15)
+              << juce::String("difference").paddedLeft(' ', 13) << std::endl;
+
+    for (const auto& scenario : scenarios)
+    {
+        for (auto compact : { false, true })
+            printResult(scenario, "float", compact, run<float>(scenario, compact, counter));
+
+        for (auto compact : { false, true })
+            printResult(scenario, "double", compact, run<double>(scenario, compact, counter));
+    }
+
+    if (! counter.isAvailable())
+        std::cout << "Cache misses can't be counted here, they need Linux with perf events allowed" << std::endl;
+
+    return 0;
+}
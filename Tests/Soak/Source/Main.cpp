@@ -0,0 +1,440 @@
+/*
+  ==============================================================================
+
+    Main.cpp
+    Created: 19 Oct 2026 10:48:15pm
+    Author:  James Muten
+    Soak test of the whole processor, the way a host drives it through a
+    long session: random block sizes, playback restarted at different
+    sample rates, the depth dials automated and the speeds changed now and
+    then. It watches the memory the process holds, how long every block
+    takes against its real time and that each channel's cycles come round
+    when its speed says they should, and writes a JSON report. It exits
+    with 1 if any of the checks fails.
+
+        WavesSoak [--hours 8] [--seed 1] [--report soak.json]
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include <iostream>
+#include <iterator>
+#include <utility>
+#include "../../../Source/PluginProcessor.h"
+
+#if JUCE_MAC || JUCE_IOS
+ #include <mach/mach.h>
+#elif JUCE_WINDOWS
+ #ifndef NOMINMAX
+  #define NOMINMAX
+ #endif
+ #include <windows.h>
+ #include <psapi.h>
+ #pragma comment (lib, "psapi.lib")
+#else
+ #include <unistd.h>
+#endif
+
+namespace
+{
+    // hosts don't go below 16 samples, and shorter blocks would be timed against less than the scheduler's jitter
+    constexpr int minBlockSize = 16, maxBlockSize = 2048;
+
+    // the tops of two cycles can be this far apart from where the speed puts them, a sample
+    // for the cycle starts the waves skip to keep to the exact period and one for the top itself
+    constexpr double maxPhaseError = 2.0;
+
+    // the memory can grow this much after the first interval, and the blocks this much slower
+    constexpr double maxResidentGrowthMB = 16.0;
+    constexpr double maxTimingDrift      = 1.5;
+
+    // a block in a thousand can overrun, the test shares the machine and can be preempted
+    constexpr double maxOverrunFraction = 0.001;
+
+    const double sampleRates[] = { 44100.0, 48000.0, 96000.0 };
+
+    // whole and fractional periods at every rate, and the slowest and fastest the dials go
+    const float speeds[] = { 60.0f, 97.0f, 120.0f, 173.0f, 240.0f, 480.0f };
+
+    // what the process holds in memory at the moment, 0 where it can't be read
+    size_t getResidentBytes()
+    {
+       #if JUCE_MAC || JUCE_IOS
+        mach_task_basic_info info{};
+        mach_msg_type_number_t count = MACH_TASK_BASIC_INFO_COUNT;
+        if (task_info(mach_task_self(), MACH_TASK_BASIC_INFO, (task_info_t)&info, &count) == KERN_SUCCESS)
+            return (size_t)info.resident_size;
+       #elif JUCE_WINDOWS
+        PROCESS_MEMORY_COUNTERS counters{};
+        if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+            return (size_t)counters.WorkingSetSize;
+       #else
+        const auto fields = juce::StringArray::fromTokens(juce::File("/proc/self/statm").loadFileAsString(), false);
+        if (fields.size() > 1)
+            return (size_t)fields[1].getLargeIntValue() * (size_t)sysconf(_SC_PAGESIZE);
+       #endif
+        return 0;
+    }
+
+    /** Finds the top of every cycle of one channel and checks it comes round a whole number of
+        periods after the first. The linear shapes come to a point at the top of the cycle, which
+        stays at unity whatever the depth, so automating the depth can't move it. */
+    class PhaseLockCheck
+    {
+    public:
+        PhaseLockCheck()
+        {
+            // room for two cycles and a quarter, at the slowest speed and the highest rate
+            history.reserve((size_t)(3.0 * 96000.0) + maxBlockSize);
+        }
+
+        // starts over at a new period, once the wave has had a couple of cycles to settle on it
+        void restart(double newPeriod)
+        {
+            period          = newPeriod;
+            samplesToSettle = (int)std::ceil(2.0 * period);
+            history.clear();
+            historyStart = 0;
+            firstTop     = -1;
+            cycle        = 1;
+        }
+
+        void process(const float* samples, int numSamples)
+        {
+            const auto settling = juce::jmin(numSamples, samplesToSettle);
+            samplesToSettle -= settling;
+            history.insert(history.end(), samples + settling, samples + numSamples);
+
+            const auto end = historyStart + (juce::int64)history.size();
+
+            if (firstTop < 0)
+            {
+                const auto length = (juce::int64)std::ceil(period);
+                if (end <= length)
+                    return;
+
+                firstTop = findTop(0, length);
+            }
+
+            // each top is looked for within a quarter of a period of where it should be
+            for (;;)
+            {
+                const auto expected = (double)firstTop + (double)cycle * period;
+                const auto from     = (juce::int64)std::floor(expected - 0.25 * period);
+                const auto to       = (juce::int64)std::ceil(expected + 0.25 * period);
+                if (end < to)
+                    break;
+
+                const auto error = std::abs((double)findTop(from, to) - expected);
+                largestError = juce::jmax(largestError, error);
+                intervalError = juce::jmax(intervalError, error);
+                cyclesChecked++;
+                cycle++;
+
+                // only the next window is needed from here on
+                const auto nextFrom = (juce::int64)std::floor((double)firstTop + (double)cycle * period - 0.25 * period);
+                const auto dropped  = juce::jlimit((juce::int64)0, (juce::int64)history.size(), nextFrom - historyStart);
+                history.erase(history.begin(), history.begin() + (std::ptrdiff_t)dropped);
+                historyStart += dropped;
+            }
+        }
+
+        double getLargestError() const noexcept { return largestError; }
+        juce::int64 getCyclesChecked() const noexcept { return cyclesChecked; }
+
+        // the largest error since this was last called
+        double takeIntervalError() noexcept { return std::exchange(intervalError, 0.0); }
+
+    private:
+        std::vector<float> history;
+        juce::int64 historyStart = 0, firstTop = -1, cycle = 1, cyclesChecked = 0;
+        double period = 1.0, largestError = 0.0, intervalError = 0.0;
+        int samplesToSettle = 0;
+
+        // the first of the highest samples between the two stream positions
+        juce::int64 findTop(juce::int64 from, juce::int64 to) const
+        {
+            const auto begin = history.begin() + (std::ptrdiff_t)(from - historyStart);
+            return from + (std::max_element(begin, begin + (std::ptrdiff_t)(to - from)) - begin);
+        }
+    };
+
+    // the slowest, the average and the overruns of the blocks in one report interval
+    struct BlockTimes
+    {
+        juce::int64 blocks = 0, samples = 0, overruns = 0;
+        double seconds = 0.0, largestLoad = 0.0; // the load is the time a block took over its length
+
+        void add(int numSamples, double sampleRate, double blockSeconds) noexcept
+        {
+            const auto load = blockSeconds * sampleRate / numSamples;
+            blocks++;
+            samples    += numSamples;
+            seconds    += blockSeconds;
+            largestLoad = juce::jmax(largestLoad, load);
+            overruns   += load >= 1.0 ? 1 : 0;
+        }
+
+        double getNanosecondsPerSample() const noexcept { return samples > 0 ? seconds * 1.0e9 / (double)samples : 0.0; }
+    };
+
+    class SoakTest
+    {
+    public:
+        explicit SoakTest(juce::int64 seed) : random(seed)
+        {
+            for (auto* parameter : processor.getParameters())
+                if (auto* ranged = dynamic_cast<juce::RangedAudioParameter*>(parameter))
+                    parametersById.set(ranged->getParameterID(), ranged);
+
+            // stereo, both channels linear in and out and dipping from the start
+            setParameter("ms", 1.0f);
+            for (auto id : { "ffL", "sfL", "ffR", "sfR" })
+                setParameter(id, 1.0f);
+
+            setParameter("dpL", 6.0f);
+            setParameter("dpR", 6.0f);
+            changeSpeeds();
+        }
+
+        juce::var run(double seconds)
+        {
+            const auto intervalSeconds = juce::jlimit(1.0, 60.0, seconds / 10.0);
+            const auto startTicks      = juce::Time::getHighResolutionTicks();
+            auto nextReport            = intervalSeconds;
+
+            restartPlayback();
+
+            for (;;)
+            {
+                const auto elapsed = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - startTicks);
+                if (elapsed >= nextReport)
+                {
+                    addInterval(elapsed);
+                    nextReport += intervalSeconds;
+                }
+
+                if (elapsed >= seconds)
+                    break;
+
+                // playback restarts and the speeds change every so often, counted in audio so a seed always plays the same
+                if (samplesToRestart <= 0)
+                    restartPlayback();
+                else if (samplesToSpeedChange <= 0)
+                    changeSpeeds();
+
+                processBlock(minBlockSize + random.nextInt(maxBlockSize - minBlockSize + 1));
+            }
+
+            return makeReport(seconds);
+        }
+
+    private:
+        WavesAudioProcessor processor;
+        juce::HashMap<juce::String, juce::RangedAudioParameter*> parametersById;
+        juce::Random random;
+
+        juce::AudioBuffer<float> buffer{ 2, maxBlockSize };
+        juce::MidiBuffer midiMessages;
+
+        double sampleRate = 48000.0;
+        float speedLeft = 240.0f, speedRight = 240.0f;
+        juce::int64 samplesToRestart = 0, samplesToSpeedChange = 0, totalBlocks = 0;
+        double audioSeconds = 0.0;
+
+        std::array<PhaseLockCheck, 2> phaseChecks;
+        BlockTimes intervalTimes;
+        juce::Array<juce::var> intervals;
+        juce::int64 restarts = 0, speedChanges = 0, totalOverruns = 0;
+
+        void setParameter(const juce::String& id, float value)
+        {
+            auto* parameter = parametersById[id];
+            jassert(parameter != nullptr);
+            parameter->setValueNotifyingHost(parameter->convertTo0to1(value));
+        }
+
+        // a new sample rate, as when the host's device or project rate changes
+        void restartPlayback()
+        {
+            sampleRate = sampleRates[random.nextInt((int)std::size(sampleRates))];
+
+            processor.releaseResources();
+            processor.setRateAndBufferSizeDetails(sampleRate, maxBlockSize);
+            processor.prepareToPlay(sampleRate, maxBlockSize);
+
+            restartPhaseChecks();
+            samplesToRestart = (juce::int64)((20.0 + 40.0 * random.nextDouble()) * sampleRate);
+            restarts++;
+        }
+
+        void changeSpeeds()
+        {
+            speedLeft  = speeds[random.nextInt((int)std::size(speeds))];
+            speedRight = speeds[random.nextInt((int)std::size(speeds))];
+            setParameter("spL", speedLeft);
+            setParameter("spR", speedRight);
+
+            restartPhaseChecks();
+            samplesToSpeedChange = (juce::int64)((5.0 + 10.0 * random.nextDouble()) * sampleRate);
+            speedChanges++;
+        }
+
+        void restartPhaseChecks()
+        {
+            phaseChecks[0].restart(60.0 / speedLeft * sampleRate);
+            phaseChecks[1].restart(60.0 / speedRight * sampleRate);
+        }
+
+        void processBlock(int numSamples)
+        {
+            // the depths sweep between 3 and 12 dB, slowly enough for the builder to keep up
+            setParameter("dpL", (float)(7.5 + 4.5 * std::sin(juce::MathConstants<double>::twoPi * audioSeconds / 47.0)));
+            setParameter("dpR", (float)(7.5 + 4.5 * std::sin(juce::MathConstants<double>::twoPi * audioSeconds / 53.0)));
+
+            // a steady input, so the output is the gain curve
+            buffer.setSize(2, numSamples, false, false, true);
+            for (int channel = 0; channel < 2; channel++)
+                juce::FloatVectorOperations::fill(buffer.getWritePointer(channel), 1.0f, numSamples);
+
+            const auto start = juce::Time::getHighResolutionTicks();
+            processor.processBlock(buffer, midiMessages);
+            intervalTimes.add(numSamples, sampleRate, juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - start));
+
+            for (int channel = 0; channel < 2; channel++)
+                phaseChecks[(size_t)channel].process(buffer.getReadPointer(channel), numSamples);
+
+            audioSeconds         += numSamples / sampleRate;
+            samplesToRestart     -= numSamples;
+            samplesToSpeedChange -= numSamples;
+        }
+
+        void addInterval(double elapsed)
+        {
+            auto* interval = new juce::DynamicObject();
+            interval->setProperty("elapsedSeconds", elapsed);
+            interval->setProperty("residentMB", (double)getResidentBytes() / (1024.0 * 1024.0));
+            interval->setProperty("blocks", intervalTimes.blocks);
+            interval->setProperty("nanosecondsPerSample", intervalTimes.getNanosecondsPerSample());
+            interval->setProperty("largestBlockLoad", intervalTimes.largestLoad);
+            interval->setProperty("overruns", intervalTimes.overruns);
+            interval->setProperty("phaseErrorLeft", phaseChecks[0].takeIntervalError());
+            interval->setProperty("phaseErrorRight", phaseChecks[1].takeIntervalError());
+            intervals.add(juce::var(interval));
+
+            totalOverruns += intervalTimes.overruns;
+            totalBlocks   += intervalTimes.blocks;
+            intervalTimes = {};
+        }
+
+        juce::var makeReport(double seconds) const
+        {
+            juce::StringArray failures;
+
+            // the first interval is the warm up, the tables and buffers for every rate are made then
+            double baselineMB = 0.0, largestMB = 0.0, firstTiming = 0.0, lastTiming = 0.0;
+            if (intervals.size() > 2)
+            {
+                baselineMB  = intervals[0]["residentMB"];
+                firstTiming = intervals[1]["nanosecondsPerSample"];
+                lastTiming  = intervals.getLast()["nanosecondsPerSample"];
+
+                for (int i = 1; i < intervals.size(); i++)
+                    largestMB = juce::jmax(largestMB, (double)intervals[i]["residentMB"]);
+            }
+            else
+            {
+                failures.add("too short to compare the intervals, run for longer");
+            }
+
+            const auto growthMB = juce::jmax(0.0, largestMB - baselineMB);
+            if (growthMB > maxResidentGrowthMB)
+                failures.add("the resident memory grew by " + juce::String(growthMB, 1) + " MB");
+
+            const auto drift = firstTiming > 0.0 ? lastTiming / firstTiming : 1.0;
+            if (drift > maxTimingDrift)
+                failures.add("the blocks got " + juce::String(drift, 2) + " times slower");
+
+            if ((double)totalOverruns > maxOverrunFraction * (double)totalBlocks)
+                failures.add(juce::String(totalOverruns) + " of " + juce::String(totalBlocks) + " blocks took longer than their length");
+
+            const char* channelNames[] = { "left", "right" };
+            for (size_t channel = 0; channel < phaseChecks.size(); channel++)
+            {
+                if (phaseChecks[channel].getCyclesChecked() == 0)
+                    failures.add(juce::String("no cycles of the ") + channelNames[channel] + " channel were checked");
+                else if (phaseChecks[channel].getLargestError() > maxPhaseError)
+                    failures.add(juce::String("the ") + channelNames[channel] + " channel drifted "
+                                 + juce::String(phaseChecks[channel].getLargestError(), 1) + " samples from its period");
+            }
+
+            auto* report = new juce::DynamicObject();
+            report->setProperty("passed", failures.isEmpty());
+            report->setProperty("failures", failures);
+            report->setProperty("seconds", seconds);
+            report->setProperty("audioSeconds", audioSeconds);
+            report->setProperty("restarts", restarts);
+            report->setProperty("speedChanges", speedChanges);
+            report->setProperty("residentGrowthMB", growthMB);
+            report->setProperty("timingDrift", drift);
+            report->setProperty("blocks", totalBlocks);
+            report->setProperty("overruns", totalOverruns);
+            report->setProperty("cyclesCheckedLeft", phaseChecks[0].getCyclesChecked());
+            report->setProperty("cyclesCheckedRight", phaseChecks[1].getCyclesChecked());
+            report->setProperty("phaseErrorLeft", phaseChecks[0].getLargestError());
+            report->setProperty("phaseErrorRight", phaseChecks[1].getLargestError());
+            report->setProperty("intervals", intervals);
+            return juce::var(report);
+        }
+
+        JUCE_DECLARE_NON_COPYABLE(SoakTest)
+    };
+}
+
+//==================================================================================================
+int main(int argc, char* argv[])
+{
+    // the value after an option, or the default when it isn't given
+    auto getOption = [&](const char* option, const juce::String& defaultValue)
+    {
+        for (int i = 1; i + 1 < argc; i++)
+            if (juce::String(argv[i]) == option)
+                return juce::String(argv[i + 1]);
+
+        return defaultValue;
+    };
+
+    const auto hours      = getOption("--hours", "1").getDoubleValue();
+    const auto seed       = getOption("--seed", "1").getLargeIntValue();
+    const auto reportPath = getOption("--report", {});
+
+    // the processor's parameters and table builder need the message manager
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+
+    juce::var report;
+    {
+        SoakTest soakTest(seed);
+        report = soakTest.run(hours * 3600.0);
+    }
+
+    const auto text = juce::JSON::toString(report);
+    if (reportPath.isNotEmpty())
+    {
+        const auto file = juce::File::getCurrentWorkingDirectory().getChildFile(reportPath);
+        if (! file.replaceWithText(text))
+        {
+            std::cerr << "Couldn't write the report to " << file.getFullPathName() << std::endl;
+            return 1;
+        }
+    }
+    else
+    {
+        std::cout << text << std::endl;
+    }
+
+    for (const auto& failure : *report["failures"].getArray())
+        std::cerr << failure.toString() << std::endl;
+
+    return report["passed"] ? 0 : 1;
+}
@@ -0,0 +1,184 @@
+/*
+  ==============================================================================
+
+    Main.cpp
+    Created: 19 Oct 2026 9:41:06pm
+    Author:  James Muten
+    Headless tests of the wave shapes. Every pair of first and second
+    functions is rendered and compared with its reference curve, and has
+    to join up where the halves meet at the peak and where the cycle
+    wraps round. After changing a generator on purpose, render new
+    reference curves with --write-references <folder> and commit them.
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include <iostream>
+#include "../../../Source/Waves.h"
+
+namespace
+{
+    // every shape is rendered the same way, a 960 sample cycle at 48 kHz with the peak 30% of the way in
+    constexpr double sampleRate   = 48000.0;
+    constexpr double cycleSeconds = 0.02;
+    constexpr double peakSeconds  = 0.006;
+    constexpr double depth        = 0.75;
+    constexpr int numFunctions    = 3; // linear, sine and Gaussian
+
+    /** One cycle of a shape, as the gains a block of ones comes out multiplied by. */
+    template <typename Type>
+    std::vector<Type> renderShape(int firstFunction, int secondFunction)
+    {
+        Waves<Type> wave;
+        wave.prepare({ sampleRate, 512, 1 });
+        wave.setParameters((Type)depth, (Type)cycleSeconds, (Type)peakSeconds);
+        wave.setFunctions(firstFunction, secondFunction);
+
+        const CustomShape noCustomShape;
+        wave.updateTable();
+        wave.buildTable(noCustomShape);
+        wave.updateTable();
+
+        std::vector<Type> gains(wave.size(), Type(1));
+        wave.process(gains.data(), (int)gains.size());
+        return gains;
+    }
+
+    juce::String getReferenceName(int firstFunction, int secondFunction)
+    {
+        return "shape_" + juce::String(firstFunction) + "_" + juce::String(secondFunction) + ".txt";
+    }
+
+    // the reference curves are built into the app, see the ReferenceCurves group of the project
+    std::vector<double> loadReference(int firstFunction, int secondFunction)
+    {
+        const auto resourceName = getReferenceName(firstFunction, secondFunction).replaceCharacter('.', '_');
+        int size = 0;
+        const auto* data = BinaryData::getNamedResource(resourceName.toRawUTF8(), size);
+
+        std::vector<double> values;
+        if (data == nullptr)
+            return values;
+
+        for (const auto& line : juce::StringArray::fromLines(juce::String::createStringFromData(data, size)))
+            if (line.isNotEmpty())
+                values.push_back(line.getDoubleValue());
+
+        return values;
+    }
+
+    bool writeReferences(const juce::File& folder)
+    {
+        if (! folder.createDirectory())
+            return false;
+
+        for (int first = 1; first <= numFunctions; first++)
+        {
+            for (int second = 1; second <= numFunctions; second++)
+            {
+                juce::String text;
+                for (auto value : renderShape<double>(first, second))
+                    text << juce::String::formatted("%.17g", value) << "\n";
+
+                if (! folder.getChildFile(getReferenceName(first, second)).replaceWithText(text))
+                    return false;
+            }
+        }
+
+        return true;
+    }
+
+    // the step into a sample from the one before, round the end of the cycle for the first
+    template <typename Type>
+    double stepInto(const std::vector<Type>& gains, size_t index)
+    {
+        const auto previous = index == 0 ? gains.size() - 1 : index - 1;
+        return std::abs((double)gains[index] - (double)gains[previous]);
+    }
+}
+
+//==================================================================================================
+class ShapeTests : public juce::UnitTest
+{
+public:
+    ShapeTests() : juce::UnitTest("Wave shapes", "Waves") {}
+
+    void runTest() override
+    {
+        const auto peak = (size_t)juce::roundToInt(peakSeconds / cycleSeconds * std::ceil(cycleSeconds * sampleRate));
+
+        for (int first = 1; first <= numFunctions; first++)
+        {
+            for (int second = 1; second <= numFunctions; second++)
+            {
+                beginTest("Functions " + juce::String(first) + " and " + juce::String(second));
+
+                const auto gains     = renderShape<double>(first, second);
+                const auto reference = loadReference(first, second);
+
+                expectEquals((int)reference.size(), (int)gains.size(), "the reference is a different length");
+                for (size_t i = 0; i < juce::jmin(gains.size(), reference.size()); i++)
+                    expectWithinAbsoluteError(gains[i], reference[i], 1.0e-9, "differs from the reference at " + juce::String((int)i));
+
+                // the single precision waves read the same shape
+                const auto floatGains = renderShape<float>(first, second);
+                expectEquals((int)floatGains.size(), (int)gains.size());
+                for (size_t i = 0; i < juce::jmin(gains.size(), floatGains.size()); i++)
+                    expectWithinAbsoluteError((double)floatGains[i], gains[i], 1.0e-5, "the float wave differs at " + juce::String((int)i));
+
+                // the dip is at the peak and stays between the depth and unity
+                const auto lowest = std::min_element(gains.begin(), gains.end());
+                expectEquals((int)(lowest - gains.begin()), (int)peak, "the dip isn't at the peak");
+                expectWithinAbsoluteError(*lowest, 1.0 - depth, 1.0e-9);
+                expect(*std::max_element(gains.begin(), gains.end()) <= 1.0 + 1.0e-12, "goes above unity");
+
+                expectContinuous(gains, peak, "at the peak");
+                expectContinuous(gains, 0, "where the cycle wraps round");
+            }
+        }
+    }
+
+private:
+    /** A shape can bend anywhere, but it mustn't step: the step into the sample can be at most
+        a few times the steeper of the steps either side of it. */
+    void expectContinuous(const std::vector<double>& gains, size_t index, const juce::String& where)
+    {
+        const auto next       = (index + 1) % gains.size();
+        const auto previous   = index == 0 ? gains.size() - 1 : index - 1;
+        const auto neighbours = juce::jmax(stepInto(gains, previous), stepInto(gains, next));
+
+        expect(stepInto(gains, index) <= 3.0 * neighbours + 1.0e-12,
+               "steps " + juce::String(stepInto(gains, index), 9) + " " + where
+               + ", the steps either side are at most " + juce::String(neighbours, 9));
+    }
+};
+
+static ShapeTests shapeTests;
+
+//==================================================================================================
+int main(int argc, char* argv[])
+{
+    if (argc == 3 && juce::String(argv[1]) == "--write-references")
+    {
+        const auto folder = juce::File::getCurrentWorkingDirectory().getChildFile(argv[2]);
+        if (! writeReferences(folder))
+        {
+            std::cerr << "Couldn't write the reference curves to " << folder.getFullPathName() << std::endl;
+            return 1;
+        }
+
+        std::cout << "Wrote the reference curves to " << folder.getFullPathName() << std::endl;
+        return 0;
+    }
+
+    juce::UnitTestRunner runner;
+    runner.setAssertOnFailure(false);
+    runner.runTestsInCategory("Waves");
+
+    int failures = 0;
+    for (int i = 0; i < runner.getNumResults(); i++)
+        failures += runner.getResult(i)->failures;
+
+    return failures > 0 ? 1 : 0;
+}